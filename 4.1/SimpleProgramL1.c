@@ -1,4 +1,4 @@
-#include "L1Cache.h"
+#include "Hierarchy.h"
 
 int main()
 {
@@ -6,28 +6,33 @@ int main()
   // set seed for random number generator
   srand(0);
 
-  int clock1, value;
+  unsigned long long clock1;
+  int value;
+  Simulator sim;
+
+  if (initSimulator(&sim, NULL) < 0)
+    return -1;
 
   for (int n = 1; n <= DRAM_SIZE / 4; n *= WORD_SIZE)
   {
 
-    resetTime();
-    initCache();
+    resetTime(&sim);
+    initCache(&sim);
 
     printf("\nNumber of words: %d\n", (n - 1) / WORD_SIZE + 1);
 
     for (int i = 0; i < n; i += WORD_SIZE)
     {
-      write(i, (unsigned char *)(&i));
-      clock1 = getTime();
-      printf("Write; Address %d; Value %d; Time %d\n", i, i, clock1);
+      write(&sim, i, (unsigned char *)(&i));
+      clock1 = getTime(&sim);
+      printf("Write; Address %d; Value %d; Time %llu\n", i, i, clock1);
     }
 
     for (int i = 0; i < n; i += WORD_SIZE)
     {
-      read(i, (unsigned char *)(&value));
-      clock1 = getTime();
-      printf("Read; Address %d; Value %d; Time %d\n", i, value, clock1);
+      read(&sim, i, (unsigned char *)(&value));
+      clock1 = getTime(&sim);
+      printf("Read; Address %d; Value %d; Time %llu\n", i, value, clock1);
     }
   }
 
@@ -41,17 +46,19 @@ int main()
     int mode = rand() % 2;
     if (mode == MODE_READ)
     {
-      read(address, (unsigned char *)(&value));
-      clock1 = getTime();
-      printf("Read; Address %d; Value %d; Time %d\n", address, value, clock1);
+      read(&sim, address, (unsigned char *)(&value));
+      clock1 = getTime(&sim);
+      printf("Read; Address %d; Value %d; Time %llu\n", address, value, clock1);
     }
     else
     {
-      write(address, (unsigned char *)(&address));
-      clock1 = getTime();
-      printf("Write; Address %d; Value %d; Time %d\n", address, address, clock1);
+      write(&sim, address, (unsigned char *)(&address));
+      clock1 = getTime(&sim);
+      printf("Write; Address %d; Value %d; Time %llu\n", address, address, clock1);
     }
   }
 
+  freeSimulator(&sim);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "Belady.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "BlockMap.h"
+
+/**************** Next uses ***************/
+
+/* swaps the previous next use of block for access i */
+static uint32_t swapUse(BlockMap *uses, uint64_t block, uint32_t i) {
+  uint32_t *use = addBlock(uses, block, BELADY_NEVER);
+  uint32_t next = *use;
+
+  *use = i;
+
+  return next;
+}
+
+uint32_t *findNextUses(const Trace *trace, uint32_t offsetBits, uint64_t *accesses) {
+  uint64_t count = 0, first;
+
+  for (uint64_t n = 0; n < trace->count; n++) {
+    const TraceRecord *record = traceRecord(trace, n);
+
+    if (record->Op != TRACE_RESET)
+      count += traceBlocks(record, offsetBits, &first);
+  }
+
+  if (count >= BELADY_NEVER) {
+    fprintf(stderr, "belady: %llu accesses, at most %u\n", (unsigned long long)count, BELADY_NEVER - 1);
+    return NULL;
+  }
+
+  uint32_t *next = malloc((count + 1) * sizeof(uint32_t));
+  if (next == NULL)
+    exit(-1);
+
+  /* block -> index of its latest access seen */
+  BlockMap uses;
+  initBlockMap(&uses, 1024);
+
+  /* backwards, so the map holds the next access of every block */
+  uint64_t i = count;
+
+  for (uint64_t n = trace->count; n-- > 0;) {
+    const TraceRecord *record = traceRecord(trace, n);
+
+    if (record->Op == TRACE_RESET) {
+      /* nothing survives a reset */
+      clearBlockMap(&uses);
+      continue;
+    }
+
+    uint32_t blocks = traceBlocks(record, offsetBits, &first);
+
+    for (uint32_t b = blocks; b-- > 0;) {
+      i--;
+      next[i] = swapUse(&uses, (first >> offsetBits) + b, (uint32_t)i);
+    }
+  }
+
+  freeBlockMap(&uses);
+
+  *accesses = count;
+
+  return next;
+}
+
+/**************** Cache ***************/
+
+int initBelady(Belady *belady, const LevelConfig *config, uint32_t offsetBits) {
+  uint64_t lines = (uint64_t)config->Sets * config->Ways;
+
+  memset(belady, 0, sizeof(Belady));
+  belady->offsetBits = offsetBits;
+  belady->indexMask = config->IndexMask;
+  belady->sets = config->Sets;
+  belady->ways = config->Ways;
+
+  belady->blocks = malloc(lines * sizeof(uint64_t));
+  belady->nextUse = malloc(lines * sizeof(uint32_t));
+  belady->heap = malloc(lines);
+  belady->position = malloc(lines);
+  belady->valid = malloc(config->Sets);
+  if (belady->blocks == NULL || belady->nextUse == NULL || belady->heap == NULL ||
+      belady->position == NULL || belady->valid == NULL)
+    exit(-1);
+
+  resetBelady(belady);
+
+  return 0;
+}
+
+/* empties every set, the counters are kept */
+void resetBelady(Belady *belady) {
+  memset(belady->valid, 0, belady->sets);
+}
+
+void freeBelady(Belady *belady) {
+  free(belady->blocks);
+  free(belady->nextUse);
+  free(belady->heap);
+  free(belady->position);
+  free(belady->valid);
+}
+
+static void swapSlots(Belady *belady, uint64_t base, uint32_t a, uint32_t b) {
+  uint8_t way = belady->heap[base + a];
+
+  belady->heap[base + a] = belady->heap[base + b];
+  belady->heap[base + b] = way;
+  belady->position[base + belady->heap[base + a]] = a;
+  belady->position[base + belady->heap[base + b]] = b;
+}
+
+static uint32_t slotUse(const Belady *belady, uint64_t base, uint32_t slot) {
+  return belady->nextUse[base + belady->heap[base + slot]];
+}
+
+static void siftUp(Belady *belady, uint64_t base, uint32_t slot) {
+  while (slot > 0 && slotUse(belady, base, (slot - 1) / 2) < slotUse(belady, base, slot)) {
+    swapSlots(belady, base, slot, (slot - 1) / 2);
+    slot = (slot - 1) / 2;
+  }
+}
+
+static void siftDown(Belady *belady, uint64_t base, uint32_t slot, uint32_t count) {
+  for (;;) {
+    uint32_t largest = slot;
+    uint32_t left = 2 * slot + 1;
+    uint32_t right = left + 1;
+
+    if (left < count && slotUse(belady, base, left) > slotUse(belady, base, largest))
+      largest = left;
+    if (right < count && slotUse(belady, base, right) > slotUse(belady, base, largest))
+      largest = right;
+    if (largest == slot)
+      return;
+
+    swapSlots(belady, base, slot, largest);
+    slot = largest;
+  }
+}
+
+void accessBelady(Belady *belady, uint64_t address, uint32_t nextUse) {
+  uint64_t block = address >> belady->offsetBits;
+  uint32_t set = (uint32_t)block & belady->indexMask;
+  uint64_t base = (uint64_t)set * belady->ways;
+  uint32_t valid = belady->valid[set];
+
+  belady->accesses++;
+
+  for (uint32_t way = 0; way < valid; way++) {
+    if (belady->blocks[base + way] == block) {
+      /* the line was due now, the minimum of the heap, so it can only go up */
+      belady->nextUse[base + way] = nextUse;
+      siftUp(belady, base, belady->position[base + way]);
+      return;
+    }
+  }
+
+  belady->misses++;
+
+  if (valid < belady->ways) {
+    belady->blocks[base + valid] = block;
+    belady->nextUse[base + valid] = nextUse;
+    belady->heap[base + valid] = valid;
+    belady->position[base + valid] = valid;
+    belady->valid[set] = valid + 1;
+    siftUp(belady, base, valid);
+    return;
+  }
+
+  /* the root is used furthest in the future */
+  uint32_t way = belady->heap[base];
+
+  belady->blocks[base + way] = block;
+  belady->nextUse[base + way] = nextUse;
+  siftDown(belady, base, 0, valid);
+}
@@ -0,0 +1,54 @@
+#ifndef BELADY_H
+#define BELADY_H
+
+#include <stdint.h>
+#include "Config.h"
+#include "Trace.h"
+
+/*
+Belady's MIN (OPT) replacement
+
+The optimal policy evicts the block whose next use is furthest in the
+future, which needs the whole access stream up front. findNextUses() makes
+one backward pass over a trace with a block -> last index map (BlockMap.h) and
+returns, for every access, the index of the next access to the same block
+(BELADY_NEVER when there is none before the end or the next reset).
+
+A Belady cache then replays the accesses in order with those indices. Each
+set keeps a binary max heap of its ways keyed by next use, so the victim is
+always the heap root: O(log ways) per access, plus the tag compare. Misses
+always allocate (demand fetch), so its miss count is a lower bound for every
+policy at the same geometry that also fills on every miss.
+
+Accesses are numbered as the engine sees them (records are split at block
+boundaries, see traceBlocks()), 32 bit indices so at most BELADY_NEVER - 1
+of them, 4 bytes each.
+*/
+
+#define BELADY_NEVER UINT32_MAX
+
+typedef struct Belady {
+  uint32_t offsetBits;
+  uint32_t indexMask;
+  uint32_t ways;
+  uint64_t *blocks;   /* block address of each line */
+  uint32_t *nextUse;  /* of each line */
+  uint8_t *heap;      /* per set, ways ordered as a max heap of nextUse */
+  uint8_t *position;  /* per line, slot of the way in its set heap */
+  uint8_t *valid;     /* per set, ways filled so far (filled in order) */
+  uint32_t sets;
+  uint64_t accesses;
+  uint64_t misses;
+} Belady;
+
+/* returns the next use of every access, NULL if the trace is too long */
+uint32_t *findNextUses(const Trace *, uint32_t offsetBits, uint64_t *accesses);
+
+int initBelady(Belady *, const LevelConfig *, uint32_t offsetBits);
+void resetBelady(Belady *);
+void freeBelady(Belady *);
+
+/* one access to address, nextUse is its entry from findNextUses() */
+void accessBelady(Belady *, uint64_t address, uint32_t nextUse);
+
+#endif
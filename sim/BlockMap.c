@@ -0,0 +1,124 @@
+#include "BlockMap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t hashKey(uint64_t key) {
+  key *= 0x9E3779B97F4A7C15ULL;
+  return key >> 32;
+}
+
+static inline int blockSlotUsed(const BlockMap *map, uint64_t slot) { return map->epochs[slot] == map->epoch; }
+
+/* slot of a key, or the empty slot where it would go */
+static uint64_t findSlot(const BlockMap *map, uint64_t key) {
+  uint64_t slot = hashKey(key) & map->mask;
+
+  while (blockSlotUsed(map, slot) && map->keys[slot] != key)
+    slot = (slot + 1) & map->mask;
+
+  return slot;
+}
+
+/* the slots start empty, epoch 0 is never current */
+static void allocSlots(BlockMap *map, uint64_t slots) {
+  map->keys = malloc(slots * sizeof(uint64_t));
+  map->values = malloc(slots * sizeof(uint32_t));
+  map->epochs = calloc(slots, sizeof(uint32_t));
+  if (map->keys == NULL || map->values == NULL || map->epochs == NULL)
+    exit(-1);
+
+  map->mask = slots - 1;
+}
+
+void initBlockMap(BlockMap *map, uint64_t slots) {
+  allocSlots(map, slots);
+  map->epoch = 1;
+  map->count = 0;
+}
+
+void freeBlockMap(BlockMap *map) {
+  free(map->keys);
+  free(map->values);
+  free(map->epochs);
+  memset(map, 0, sizeof(BlockMap));
+}
+
+void clearBlockMap(BlockMap *map) {
+  if (++map->epoch == 0) {
+    memset(map->epochs, 0, (map->mask + 1) * sizeof(uint32_t));
+    map->epoch = 1;
+  }
+
+  map->count = 0;
+}
+
+/* doubles the table when one more key would fill more than half of it */
+static void growMap(BlockMap *map) {
+  if (2 * (map->count + 1) <= map->mask)
+    return;
+
+  BlockMap old = *map;
+
+  allocSlots(map, 2 * (old.mask + 1));
+
+  for (uint64_t slot = 0; slot <= old.mask; slot++) {
+    if (blockSlotUsed(&old, slot)) {
+      uint64_t grown = findSlot(map, old.keys[slot]);
+
+      map->keys[grown] = old.keys[slot];
+      map->values[grown] = old.values[slot];
+      map->epochs[grown] = map->epoch;
+    }
+  }
+
+  free(old.keys);
+  free(old.values);
+  free(old.epochs);
+}
+
+uint32_t *findBlock(const BlockMap *map, uint64_t key) {
+  uint64_t slot = findSlot(map, key);
+
+  return blockSlotUsed(map, slot) ? &map->values[slot] : NULL;
+}
+
+uint32_t *addBlock(BlockMap *map, uint64_t key, uint32_t value) {
+  growMap(map);
+
+  uint64_t slot = findSlot(map, key);
+
+  if (!blockSlotUsed(map, slot)) {
+    map->keys[slot] = key;
+    map->values[slot] = value;
+    map->epochs[slot] = map->epoch;
+    map->count++;
+  }
+
+  return &map->values[slot];
+}
+
+void removeBlock(BlockMap *map, uint64_t key) {
+  uint64_t slot = findSlot(map, key), next = slot;
+
+  if (!blockSlotUsed(map, slot))
+    return;
+
+  map->epochs[slot] = 0;
+  map->count--;
+
+  /* later entries of the run move back unless their home is past the hole */
+  while (blockSlotUsed(map, next = (next + 1) & map->mask)) {
+    uint64_t home = hashKey(map->keys[next]) & map->mask;
+
+    /* the entry stays if its home lies cyclically in (slot, next] */
+    if (slot <= next ? (slot < home && home <= next) : (slot < home || home <= next))
+      continue;
+
+    map->keys[slot] = map->keys[next];
+    map->values[slot] = map->values[next];
+    map->epochs[slot] = map->epoch;
+    map->epochs[next] = 0;
+    slot = next;
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef BLOCKMAP_H
+#define BLOCKMAP_H
+
+#include <stdint.h>
+
+/*
+64 bit key -> 32 bit value hash map
+
+The one table behind the seen blocks of the shadow caches (Shadow.h), the
+block -> node index of the stack distance analysis (StackDistance.h), the
+next uses of Belady's policy (Belady.h) and the pcs of a Profile
+(Profile.h). Open addressing with linear probing, keys are hashed by a
+Fibonacci multiply and the table doubles to stay at most half full, it
+never shrinks. Removal shifts the rest of the probe run back, so there are
+no tombstones.
+
+Clearing is constant time like initCache(): every slot carries the epoch it
+was filled in and only slots of the current epoch hold a key, so a clear
+just starts a new epoch.
+
+A pointer to a value is only good until the next addBlock().
+*/
+
+typedef struct BlockMap {
+  uint64_t *keys;
+  uint32_t *values;
+  uint32_t *epochs;     /* per slot, the slot is empty unless it is epoch */
+  uint32_t epoch;       /* never 0 */
+  uint64_t mask;        /* slots - 1, slots a power of two */
+  uint64_t count;
+} BlockMap;
+
+void initBlockMap(BlockMap *, uint64_t slots);
+void freeBlockMap(BlockMap *);
+
+/* removes every key, constant time */
+void clearBlockMap(BlockMap *);
+
+/* returns the value of key, NULL when it is not in the map */
+uint32_t *findBlock(const BlockMap *, uint64_t key);
+
+/* returns the value of key, added as value when it is not in the map yet */
+uint32_t *addBlock(BlockMap *, uint64_t key, uint32_t value);
+
+void removeBlock(BlockMap *, uint64_t key);
+
+#endif
@@ -0,0 +1,101 @@
+#include "Hierarchy.h"
+#include "Coherence.h"
+
+/**************** Utils ***************/
+
+/* returns the way of peer holding the block, -1 if it has none */
+static int findPeerWay(Level *peer, uint32_t lineIndex, uint64_t tag) {
+  if (peer->setEpoch[lineIndex] != peer->epoch)
+    refreshSet(peer, lineIndex);
+
+  const uint64_t *tags = &peer->tags[lineIndex * peer->ways];
+  uint64_t valid = peer->validWays[lineIndex];
+
+  for (; valid != 0; valid &= valid - 1) {
+    uint32_t way = __builtin_ctzll(valid);
+
+    if (tags[way] == tag)
+      return way;
+  }
+
+  return -1;
+}
+
+/* M -> S or M -> I, the block goes back to the shared levels first */
+static void writeBackPeer(Level *peer, uint64_t address, uint32_t lineIndex, uint32_t way) {
+  peer->sim->stats.coherence.Interventions++;
+  peer->stats->Writebacks++;
+
+  accessNext(peer, address, getLineData(peer, lineIndex, way), MODE_WRITE);
+  peer->dirtyWays[lineIndex] &= ~(1ULL << way);
+}
+
+static void invalidatePeer(Level *peer, uint32_t lineIndex, uint32_t way, uint32_t word) {
+  uint64_t bit = 1ULL << way;
+
+  peer->validWays[lineIndex] &= ~bit;
+  peer->sharedWays[lineIndex] &= ~bit;
+  peer->lostWays[lineIndex] |= bit;
+  peer->lostWord[lineIndex * peer->ways + way] = word;
+
+  peer->sim->stats.coherence.Invalidations++;
+}
+
+/**************** Snooping ***************/
+
+uint32_t snoopMiss(Level *level, uint64_t address, uint32_t lineIndex, uint64_t matches, uint32_t mode) {
+  Simulator *sim = level->sim;
+  uint64_t blockAddress = address & ~(uint64_t)level->offsetMask;
+  uint64_t tag = getTag(level, address);
+  uint32_t word = getBlockOffset(level, address) / WORD_SIZE;
+  uint32_t shared = 0;
+
+  /* a block this L1 lost to another core's write */
+  uint64_t lost = matches & level->lostWays[lineIndex];
+  if (lost != 0) {
+    sim->stats.coherence.CoherenceMisses++;
+
+    if (level->lostWord[lineIndex * level->ways + __builtin_ctzll(lost)] != word)
+      sim->stats.coherence.FalseSharing++;
+  }
+
+  for (uint32_t core = 0; core < sim->cache.cores; core++) {
+    Level *peer = sim->cache.l1[core];
+
+    if (peer == level)
+      continue;
+
+    int way = findPeerWay(peer, lineIndex, tag);
+    if (way < 0)
+      continue;
+
+    if ((peer->dirtyWays[lineIndex] >> way) & 1)
+      writeBackPeer(peer, blockAddress, lineIndex, way);
+
+    if (mode == MODE_WRITE)
+      invalidatePeer(peer, lineIndex, way, word);
+    else {
+      peer->sharedWays[lineIndex] |= 1ULL << way;
+      shared = 1;
+    }
+  }
+
+  return shared;
+}
+
+void snoopUpgrade(Level *level, uint64_t address, uint32_t lineIndex) {
+  Simulator *sim = level->sim;
+  uint64_t tag = getTag(level, address);
+  uint32_t word = getBlockOffset(level, address) / WORD_SIZE;
+
+  sim->stats.coherence.Upgrades++;
+
+  /* shared copies are never dirty */
+  for (uint32_t core = 0; core < sim->cache.cores; core++) {
+    Level *peer = sim->cache.l1[core];
+    int way;
+
+    if (peer != level && (way = findPeerWay(peer, lineIndex, tag)) >= 0)
+      invalidatePeer(peer, lineIndex, way, word);
+  }
+}
@@ -0,0 +1,51 @@
+#ifndef COHERENCE_H
+#define COHERENCE_H
+
+#include <stdint.h>
+
+/*
+MESI coherence between the private L1s (cores > 1)
+
+Every core has its own L1, all of them in front of the same L2 .. Ln. The
+MESI state of a line comes from the masks of its set:
+
+  M  valid and dirty
+  E  valid, neither dirty nor shared
+  S  valid and shared, never dirty
+  I  not valid
+
+An L1 snoops the others on a miss and on a write to a shared line. All the
+L1s have the same geometry, so a block is in the same set of every one:
+
+  read miss    a modified copy is written back to the next level and every
+               copy becomes S, the new line is S when there were copies and
+               E otherwise
+  write miss   every copy is invalidated, written back first if modified,
+               the new line is M
+  write hit S  every other copy is invalidated (an upgrade)
+  write hit E  silently becomes M
+
+The requesting L1 then fills from the next level as usual, which already
+holds the latest data since a modified copy is written back first, so
+values read stay correct.
+
+A line invalidated by another core's write remembers the word written
+(lostWord). The next miss on that block in this L1 is a coherence miss,
+and false sharing when it accesses another word. Only the invalidating
+write is known, later writes of the new owner hit silently, so false
+sharing is an upper bound.
+*/
+
+struct Level;
+
+/*
+snoops the other L1s on a miss of mode, before the block is fetched.
+matches holds the ways of the set with the tag, valid or not. Returns 1
+when other copies remain and the new line is S
+*/
+uint32_t snoopMiss(struct Level *, uint64_t, uint32_t, uint64_t, uint32_t);
+
+/* invalidates the other copies of a shared line being written */
+void snoopUpgrade(struct Level *, uint64_t, uint32_t);
+
+#endif
@@ -0,0 +1,383 @@
+#include "Config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Cache.h"
+#include "Policy.h"
+#include "Prefetch.h"
+#include "Victim.h"
+
+/* levels Cache.h does not describe, only used once configured */
+#define L3_READ_TIME 30
+#define L3_WRITE_TIME 15
+#define L4_READ_TIME 50
+#define L4_WRITE_TIME 25
+
+static const char *inclusions[] = {"nine", "inclusive", "exclusive"};
+
+static Config current;
+static int loaded = 0;
+
+/**************** Utils ***************/
+
+static int isPowerOfTwo(uint32_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint32_t log2u(uint32_t value) {
+  uint32_t bits = 0;
+
+  while (value >>= 1)
+    bits++;
+
+  return bits;
+}
+
+/**************** Defaults ***************/
+
+void defaultConfig(Config *config) {
+  memset(config, 0, sizeof(Config));
+
+  config->Levels = CACHE_LEVELS;
+  config->BlockSize = BLOCK_SIZE;
+  config->DramSize = DRAM_SIZE;
+  config->DramReadTime = DRAM_READ_TIME;
+  config->DramWriteTime = DRAM_WRITE_TIME;
+  config->Cores = 1;
+  config->VictimTime = VICTIM_TIME;
+
+  for (uint32_t i = 0; i < MAX_LEVELS; i++) {
+    config->level[i].WriteAllocate = 1;
+    config->level[i].PrefetchDegree = 1;
+  }
+
+  config->level[0].Size = L1_SIZE;
+  config->level[0].Ways = L1_WAYS;
+  config->level[0].ReadTime = L1_READ_TIME;
+  config->level[0].WriteTime = L1_WRITE_TIME;
+
+  config->level[1].Size = L2_SIZE;
+  config->level[1].Ways = L2_WAYS;
+  config->level[1].ReadTime = L2_READ_TIME;
+  config->level[1].WriteTime = L2_WRITE_TIME;
+
+  /* L3 and L4 need a size before they can be used */
+  config->level[2].Ways = 1;
+  config->level[2].ReadTime = L3_READ_TIME;
+  config->level[2].WriteTime = L3_WRITE_TIME;
+
+  config->level[3].Ways = 1;
+  config->level[3].ReadTime = L4_READ_TIME;
+  config->level[3].WriteTime = L4_WRITE_TIME;
+}
+
+/**************** Parsing ***************/
+
+static uint32_t *findOption(Config *config, const char *key) {
+  if (strcmp(key, "levels") == 0)
+    return &config->Levels;
+  if (strcmp(key, "block_size") == 0)
+    return &config->BlockSize;
+  if (strcmp(key, "dram.read_time") == 0)
+    return &config->DramReadTime;
+  if (strcmp(key, "dram.write_time") == 0)
+    return &config->DramWriteTime;
+  if (strcmp(key, "tag_only") == 0)
+    return &config->TagOnly;
+  if (strcmp(key, "cores") == 0)
+    return &config->Cores;
+  if (strcmp(key, "victim.entries") == 0)
+    return &config->VictimEntries;
+  if (strcmp(key, "victim.time") == 0)
+    return &config->VictimTime;
+  if (strcmp(key, "classify") == 0)
+    return &config->Classify;
+
+  /* l<n>.<field> */
+  if (key[0] == 'l' && key[1] >= '1' && key[1] < '1' + MAX_LEVELS && key[2] == '.') {
+    LevelConfig *level = &config->level[key[1] - '1'];
+    const char *field = key + 3;
+
+    if (strcmp(field, "size") == 0)
+      return &level->Size;
+    if (strcmp(field, "ways") == 0)
+      return &level->Ways;
+    if (strcmp(field, "read_time") == 0)
+      return &level->ReadTime;
+    if (strcmp(field, "write_time") == 0)
+      return &level->WriteTime;
+    if (strcmp(field, "write_through") == 0)
+      return &level->WriteThrough;
+    if (strcmp(field, "write_allocate") == 0)
+      return &level->WriteAllocate;
+    if (strcmp(field, "write_buffer") == 0)
+      return &level->WriteBuffer;
+    if (strcmp(field, "prefetch_degree") == 0)
+      return &level->PrefetchDegree;
+    if (strcmp(field, "mshrs") == 0)
+      return &level->Mshrs;
+  }
+
+  return NULL;
+}
+
+int setConfigOption(Config *config, const char *key, const char *value) {
+  uint32_t *option = findOption(config, key);
+  char *end;
+
+  /* dram.size is 64 bits wide */
+  if (strcmp(key, "dram.size") == 0) {
+    unsigned long long parsed = strtoull(value, &end, 0);
+
+    if (end == value || *end != '\0') {
+      fprintf(stderr, "config: bad value for %s: %s\n", key, value);
+      return -1;
+    }
+
+    config->DramSize = parsed;
+    return 0;
+  }
+
+  /* l<n>.policy takes a name */
+  if (option == NULL && key[0] == 'l' && key[1] >= '1' && key[1] < '1' + MAX_LEVELS &&
+      strcmp(key + 2, ".policy") == 0) {
+    int policy = findPolicy(value);
+
+    if (policy < 0) {
+      fprintf(stderr, "config: unknown policy %s\n", value);
+      return -1;
+    }
+
+    config->level[key[1] - '1'].Policy = policy;
+    return 0;
+  }
+
+  if (option == NULL && strcmp(key, "inclusion") == 0) {
+    for (uint32_t i = 0; i < sizeof(inclusions) / sizeof(inclusions[0]); i++) {
+      if (strcmp(inclusions[i], value) == 0) {
+        config->Inclusion = i;
+        return 0;
+      }
+    }
+
+    fprintf(stderr, "config: unknown inclusion %s\n", value);
+    return -1;
+  }
+
+  /* l<n>.prefetch too */
+  if (option == NULL && key[0] == 'l' && key[1] >= '1' && key[1] < '1' + MAX_LEVELS &&
+      strcmp(key + 2, ".prefetch") == 0) {
+    int prefetcher = findPrefetcher(value);
+
+    if (prefetcher < 0) {
+      fprintf(stderr, "config: unknown prefetcher %s\n", value);
+      return -1;
+    }
+
+    config->level[key[1] - '1'].Prefetch = prefetcher;
+    return 0;
+  }
+
+  if (option == NULL) {
+    fprintf(stderr, "config: unknown option %s\n", key);
+    return -1;
+  }
+
+  unsigned long parsed = strtoul(value, &end, 0);
+  if (end == value || *end != '\0' || parsed > UINT32_MAX) {
+    fprintf(stderr, "config: bad value for %s: %s\n", key, value);
+    return -1;
+  }
+
+  *option = (uint32_t)parsed;
+  return 0;
+}
+
+/* "key=value" or "key = value", surrounding blanks are ignored */
+int parseConfigOption(Config *config, const char *text) {
+  char key[64], value[64];
+
+  if (sscanf(text, " %63[^= \t] = %63s", key, value) != 2) {
+    fprintf(stderr, "config: expected key=value, got %s\n", text);
+    return -1;
+  }
+
+  return setConfigOption(config, key, value);
+}
+
+int loadConfig(Config *config, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "config: cannot open %s\n", path);
+    return -1;
+  }
+
+  char line[256];
+  int failed = 0;
+
+  while (!failed && fgets(line, sizeof(line), file) != NULL) {
+    char first;
+
+    /* skip blank lines and comments */
+    if (sscanf(line, " %c", &first) != 1 || first == '#')
+      continue;
+
+    failed = parseConfigOption(config, line) < 0;
+  }
+
+  fclose(file);
+  return failed ? -1 : 0;
+}
+
+/**************** Derived values ***************/
+
+/*
+address = | tag | index | block offset |
+
+block offset = log2(block size) bits
+index = log2(sets) bits, sets = size / block size / ways
+tag = the remaining most significant bits
+*/
+int finalizeConfig(Config *config) {
+  if (!isPowerOfTwo(config->BlockSize) || config->BlockSize < WORD_SIZE) {
+    fprintf(stderr, "config: block_size must be a power of two >= %d\n", WORD_SIZE);
+    return -1;
+  }
+
+  if (config->DramSize != 0 && config->DramSize < config->BlockSize) {
+    fprintf(stderr, "config: dram.size must hold at least one block, or be 0\n");
+    return -1;
+  }
+
+  if (config->TagOnly > 1) {
+    fprintf(stderr, "config: tag_only must be 0 or 1\n");
+    return -1;
+  }
+
+  if (config->Classify > 1) {
+    fprintf(stderr, "config: classify must be 0 or 1\n");
+    return -1;
+  }
+
+  if (config->Levels < 1 || config->Levels > MAX_LEVELS) {
+    fprintf(stderr, "config: levels must be between 1 and %d\n", MAX_LEVELS);
+    return -1;
+  }
+
+  if (config->Cores < 1 || config->Cores > MAX_CORES) {
+    fprintf(stderr, "config: cores must be between 1 and %d\n", MAX_CORES);
+    return -1;
+  }
+
+  if (config->VictimEntries > MAX_VICTIM_ENTRIES) {
+    fprintf(stderr, "config: victim.entries must be at most %d\n", MAX_VICTIM_ENTRIES);
+    return -1;
+  }
+
+  if (config->VictimEntries > 0 && config->Cores > 1) {
+    fprintf(stderr, "config: the victim cache needs cores = 1\n");
+    return -1;
+  }
+
+  if (config->Inclusion != INCLUSION_NINE && config->VictimEntries > 0) {
+    fprintf(stderr, "config: the victim cache needs inclusion = nine\n");
+    return -1;
+  }
+
+  config->OffsetBits = log2u(config->BlockSize);
+  config->OffsetMask = config->BlockSize - 1;
+
+  for (uint32_t i = 0; i < MAX_LEVELS; i++) {
+    LevelConfig *level = &config->level[i];
+
+    if (i >= config->Levels) {
+      level->Sets = 0;
+      continue;
+    }
+
+    if (!isPowerOfTwo(level->Size) || !isPowerOfTwo(level->Ways) ||
+        level->Size < config->BlockSize * level->Ways) {
+      fprintf(stderr, "config: l%u.size and l%u.ways must be powers of two "
+                      "holding at least one set\n", i + 1, i + 1);
+      return -1;
+    }
+
+    if (level->Ways > MAX_WAYS) {
+      fprintf(stderr, "config: l%u.ways must be at most %d\n", i + 1, MAX_WAYS);
+      return -1;
+    }
+
+    if (level->WriteThrough > 1 || level->WriteAllocate > 1) {
+      fprintf(stderr, "config: l%u.write_through and l%u.write_allocate must be 0 or 1\n",
+              i + 1, i + 1);
+      return -1;
+    }
+
+    if (level->WriteBuffer > MAX_WRITE_BUFFER) {
+      fprintf(stderr, "config: l%u.write_buffer must be at most %d\n", i + 1, MAX_WRITE_BUFFER);
+      return -1;
+    }
+
+    if (level->Mshrs > MAX_MSHRS) {
+      fprintf(stderr, "config: l%u.mshrs must be at most %d\n", i + 1, MAX_MSHRS);
+      return -1;
+    }
+
+    if (level->PrefetchDegree < 1 || level->PrefetchDegree > level->Size / config->BlockSize) {
+      fprintf(stderr, "config: l%u.prefetch_degree must be between 1 and the blocks of l%u\n",
+              i + 1, i + 1);
+      return -1;
+    }
+
+    /* exclusive levels trade whole blocks, see Hierarchy.h */
+    if (config->Inclusion == INCLUSION_EXCLUSIVE && i + 1 < config->Levels &&
+        (level->WriteThrough || !level->WriteAllocate || level->WriteBuffer > 0)) {
+      fprintf(stderr, "config: inclusion = exclusive needs l%u to be write back and write "
+                      "allocate, without a write buffer\n", i + 1);
+      return -1;
+    }
+
+    /* and only L1 is accessed in place, the levels below never miss on their own */
+    if (config->Inclusion == INCLUSION_EXCLUSIVE && i > 0 &&
+        (level->Mshrs > 0 || level->Prefetch != PREFETCH_NONE)) {
+      fprintf(stderr, "config: inclusion = exclusive allows no mshrs or prefetch on l%u\n", i + 1);
+      return -1;
+    }
+
+    level->Sets = level->Size / config->BlockSize / level->Ways;
+    level->IndexMask = level->Sets - 1;
+    level->TagShift = config->OffsetBits + log2u(level->Sets);
+  }
+
+  return 0;
+}
+
+/**************** Current configuration ***************/
+
+const Config *getConfig() {
+  if (!loaded) {
+    const char *path = getenv("CACHE_CONFIG");
+
+    defaultConfig(&current);
+
+    if ((path != NULL && loadConfig(&current, path) < 0) || finalizeConfig(&current) < 0)
+      exit(-1);
+
+    loaded = 1;
+  }
+
+  return &current;
+}
+
+int setConfig(const Config *config) {
+  Config candidate = *config;
+
+  if (finalizeConfig(&candidate) < 0)
+    return -1;
+
+  current = candidate;
+  loaded = 1;
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+
+/*
+Runtime cache geometry
+
+Defaults come from the macros in Cache.h, any of them can then be overridden
+at startup from a config file or from "key=value" options:
+
+  levels = 2                  (l1 .. l<levels> are used, the last one
+                               misses to DRAM)
+  block_size = 64
+  dram.size = 65536           (0 for the whole 64 bit address space, an
+                               access past it is an error)
+  dram.read_time = 100
+  dram.write_time = 50
+  tag_only = 0                (1 keeps no data, for hit/miss and timing
+                               studies, see Hierarchy.h)
+  cores = 1                   (private L1s kept coherent with MESI, the
+                               levels below are shared, see Coherence.h)
+  inclusion = nine            (nine, inclusive or exclusive, between every
+                               level and the next, see Hierarchy.h)
+  victim.entries = 0          (blocks of the victim cache behind L1, 0 for
+                               none, see Victim.h)
+  victim.time = 2             (latency of a victim cache hit)
+  classify = 0                (1 splits the misses of every level into
+                               compulsory, capacity and conflict, see
+                               Shadow.h)
+  l1.size = 16384
+  l1.ways = 1
+  l1.read_time = 1
+  l1.write_time = 1
+  l1.policy = lru             (lru, plru, srrip, brrip, fifo or random)
+  l1.write_through = 0        (1 forwards every write to the next level,
+                               lines are never dirty)
+  l1.write_allocate = 1       (0 forwards write misses without a fill)
+  l1.write_buffer = 0         (entries of the write buffer in front of
+                               the next level, 0 for none)
+  l1.prefetch = none          (none, next, stride or stream, see
+                               Prefetch.h)
+  l1.prefetch_degree = 1      (blocks fetched ahead)
+  l1.mshrs = 0                (misses in flight, 0 for a blocking level,
+                               see Hierarchy.h)
+  l2.size = ...               (same keys for l2 .. l4)
+
+Lines starting with '#' are comments. Sizes must be powers of two.
+finalizeConfig() derives the shifts and masks used to split addresses so the
+access paths never divide or recompute them.
+*/
+
+#define MAX_LEVELS 4
+#define MAX_CORES 8
+#define MAX_WRITE_BUFFER 1024
+#define MAX_MSHRS 64
+#define VICTIM_TIME 2
+
+#define INCLUSION_NINE 0
+#define INCLUSION_INCLUSIVE 1
+#define INCLUSION_EXCLUSIVE 2
+
+typedef struct LevelConfig {
+  uint32_t Size;      /* in bytes */
+  uint32_t Ways;
+  uint32_t ReadTime;
+  uint32_t WriteTime;
+  uint32_t Policy;    /* POLICY_* from Policy.h */
+  uint32_t WriteThrough;  /* 0 or 1 */
+  uint32_t WriteAllocate; /* 0 or 1 */
+  uint32_t WriteBuffer;   /* entries */
+  uint32_t Prefetch;      /* PREFETCH_* from Prefetch.h */
+  uint32_t PrefetchDegree;
+  uint32_t Mshrs;
+
+  /* derived by finalizeConfig() */
+  uint32_t Sets;
+  uint32_t IndexMask; /* applied after shifting out the block offset */
+  uint32_t TagShift;
+} LevelConfig;
+
+typedef struct Config {
+  uint32_t Levels;
+  uint32_t BlockSize; /* in bytes */
+  uint64_t DramSize;  /* in bytes, 0 for no bound */
+  uint32_t DramReadTime;
+  uint32_t DramWriteTime;
+  uint32_t TagOnly;   /* 0 or 1 */
+  uint32_t Cores;
+  uint32_t Inclusion; /* INCLUSION_* */
+  uint32_t VictimEntries;
+  uint32_t VictimTime;
+  uint32_t Classify;  /* 0 or 1 */
+  LevelConfig level[MAX_LEVELS];
+
+  /* derived by finalizeConfig() */
+  uint32_t OffsetBits;
+  uint32_t OffsetMask;
+} Config;
+
+void defaultConfig(Config *);
+int setConfigOption(Config *, const char *, const char *);
+int parseConfigOption(Config *, const char *);
+int loadConfig(Config *, const char *);
+int finalizeConfig(Config *);
+
+/*
+configuration used by initSimulator() when given none, defaults plus the
+file named by the CACHE_CONFIG environment variable unless setConfig() was
+called first
+*/
+const Config *getConfig();
+int setConfig(const Config *);
+
+#endif
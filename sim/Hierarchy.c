@@ -0,0 +1,1081 @@
+#include "Hierarchy.h"
+#include "Coherence.h"
+#include "Prefetch.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/**************** Utils ***************/
+
+/*
+returns block offset, log2(block size) least significant bits of address
+
+block size = 16 * word size = 16 * 4 = 64 bytes = 2^6 bytes by default
+so, block offset = 6 bits, offsetMask = 0x3F
+*/
+uint32_t getBlockOffset(const Level *level, uint64_t address) {
+  return address & level->offsetMask;
+}
+
+/*
+returns line index, log2(sets) bits of address above the block offset
+
+256 sets = 2^8 for the default L1
+so, line index = 8 bits, IndexMask = 0xFF
+*/
+uint32_t getLineIndex(const Level *level, uint64_t address) {
+  return (address >> level->offsetBits) & level->config->IndexMask;
+}
+
+/*
+returns tag, the most significant bits of address
+
+64 - 6 - 8 = 50 bits for the default L1, TagShift = 14
+*/
+uint64_t getTag(const Level *level, uint64_t address) {
+  return address >> level->config->TagShift;
+}
+
+/* rebuilds the address of the block held by a line */
+uint64_t getBlockAddress(const Level *level, uint64_t tag, uint32_t lineIndex) {
+  return (tag << level->config->TagShift) | ((uint64_t)lineIndex << level->offsetBits);
+}
+
+/**************** Time Manipulation ***************/
+void resetTime(Simulator *sim) {
+  sim->time = 0;
+  sim->ready = 0;
+  sim->drain = 0;
+}
+
+uint64_t getTime(const Simulator *sim) { return sim->time > sim->drain ? sim->time : sim->drain; }
+
+#define SERVING_DONE UINT32_MAX
+
+/* the current access is served here if it came down this far */
+static inline void serveAccess(Simulator *sim, uint32_t index) {
+  if (sim->serving == index) {
+    sim->served = index;
+    sim->serving = SERVING_DONE;
+  }
+}
+
+/* a miss here takes the current access one level further down */
+static inline void passAccess(Simulator *sim, uint32_t index) {
+  if (sim->serving == index)
+    sim->serving = index + 1;
+}
+
+/****************  RAM memory (byte addressable) ***************/
+
+/* dram.size = 0 is the whole address space, an access past a bound ends the run */
+static void checkDRAM(const Simulator *sim, uint64_t address, uint32_t size) {
+  uint64_t dramSize = sim->config.DramSize;
+
+  if (dramSize != 0 && (dramSize < size || address > dramSize - size)) {
+    fprintf(stderr, "dram: access to 0x%llx is past dram.size = 0x%llx, see Config.h\n",
+            (unsigned long long)address, (unsigned long long)dramSize);
+    exit(-1);
+  }
+}
+
+void accessDRAM(Simulator *sim, uint64_t address, uint8_t *data, uint32_t mode) {
+  const Config *config = &sim->config;
+
+  serveAccess(sim, sim->cache.levels);
+
+  checkDRAM(sim, address, config->BlockSize);
+
+  if (mode == MODE_READ) {
+    sim->stats.dram.Reads++;
+    sim->stats.dram.BytesRead += config->BlockSize;
+
+    /* a block never spans pages */
+    if (!config->TagOnly)
+      memcpy(data, getMemoryPage(&sim->DRAM, address) + (address & sim->pageMask), config->BlockSize);
+    sim->time += config->DramReadTime;
+  }
+
+  if (mode == MODE_WRITE) {
+    sim->stats.dram.Writes++;
+    sim->stats.dram.BytesWritten += config->BlockSize;
+
+    if (!config->TagOnly)
+      memcpy(getMemoryPage(&sim->DRAM, address) + (address & sim->pageMask), data, config->BlockSize);
+    sim->time += config->DramWriteTime;
+  }
+}
+
+void writeDRAM(Simulator *sim, uint64_t address, uint8_t *data, uint32_t size) {
+  const Config *config = &sim->config;
+
+  serveAccess(sim, sim->cache.levels);
+
+  if (size == config->BlockSize) {
+    accessDRAM(sim, address, data, MODE_WRITE);
+    return;
+  }
+
+  checkDRAM(sim, address, size);
+
+  sim->stats.dram.Writes++;
+  sim->stats.dram.BytesWritten += size;
+
+  if (!config->TagOnly)
+    memcpy(getMemoryPage(&sim->DRAM, address) + (address & sim->pageMask), data, size);
+  sim->time += config->DramWriteTime;
+}
+
+/*********************** Simulator *************************/
+
+int initSimulator(Simulator *sim, const Config *config) {
+  memset(sim, 0, sizeof(Simulator));
+  sim->serving = SERVING_DONE;
+
+  sim->config = config != NULL ? *config : *getConfig();
+  if (finalizeConfig(&sim->config) < 0)
+    return -1;
+
+  initCache(sim);
+
+  return 0;
+}
+
+static void freeLines(Level *level) {
+  free(level->tags);
+  free(level->data);
+  free(level->parkedData);
+  free(level->validWays);
+  free(level->dirtyWays);
+  free(level->sharedWays);
+  free(level->lostWays);
+  free(level->lostWord);
+  free(level->prefetchedWays);
+  free(level->readyTime);
+  free(level->pollution);
+  free(level->pendingWays);
+  free(level->setEpoch);
+}
+
+void freeSimulator(Simulator *sim) {
+  for (uint32_t i = 0; i < MAX_LEVELS + MAX_CORES - 1; i++) {
+    Level *level = i < MAX_LEVELS ? &sim->cache.level[i] : &sim->cache.privateL1[i - MAX_LEVELS];
+
+    freeLines(level);
+    free(level->policyState);
+    free(level->writeBuffer);
+    free(level->prefetchState);
+    free(level->mshr);
+    freeShadow(&level->shadow);
+  }
+
+  freeVictimCache(&sim->victim);
+  freeMemory(&sim->DRAM);
+  memset(sim, 0, sizeof(Simulator));
+}
+
+/*********************** Cache *************************/
+
+void initCache(Simulator *sim) {
+  const Config *config = &sim->config;
+
+  initDRAM(sim);
+
+  sim->cache.levels = config->Levels;
+  sim->cache.cores = config->Cores;
+  sim->stats.levels = config->Levels;
+  sim->stats.cores = config->Cores;
+  sim->stats.victimEntries = config->VictimEntries;
+
+  /* initialize from the last level up so every level can point to its next */
+  for (int i = config->Levels - 1; i >= 0; i--) {
+    Level *next = i + 1 < (int)config->Levels ? &sim->cache.level[i + 1] : NULL;
+
+    initLevel(sim, &sim->cache.level[i], &config->level[i], next);
+  }
+
+  /* the private L1s of the other cores share the L1 config, stats and next level */
+  sim->cache.l1[0] = &sim->cache.level[0];
+
+  for (uint32_t core = 1; core < config->Cores; core++) {
+    Level *l1 = &sim->cache.privateL1[core - 1];
+
+    initLevel(sim, l1, &config->level[0], sim->cache.level[0].next);
+    l1->core = core;
+    l1->coherent = 1;
+    sim->cache.l1[core] = l1;
+  }
+
+  sim->cache.level[0].core = 0;
+  sim->cache.level[0].coherent = config->Cores > 1;
+
+  if (config->VictimEntries > 0) {
+    initVictimCache(&sim->victim, config->VictimEntries, config->BlockSize, config->TagOnly);
+    sim->cache.level[0].victim = &sim->victim;
+  }
+}
+
+/* Initialize DRAM, pages are only zeroed again when they are next used */
+void initDRAM(Simulator *sim) {
+  const Config *config = &sim->config;
+  uint32_t pageBits = config->OffsetBits > DRAM_PAGE_BITS ? config->OffsetBits : DRAM_PAGE_BITS;
+
+  if (sim->DRAM.pageBits != pageBits) {
+    freeMemory(&sim->DRAM);
+    initMemory(&sim->DRAM, pageBits);
+    sim->pageMask = ((uint64_t)1 << pageBits) - 1;
+  } else {
+    resetMemory(&sim->DRAM);
+  }
+}
+
+/*********************** Level *************************/
+
+/* Initialize a level, lines are only reallocated when the geometry changed */
+void initLevel(Simulator *sim, Level *level, const LevelConfig *levelConfig, Level *next) {
+  const Config *config = &sim->config;
+  uint32_t lines = levelConfig->Sets * levelConfig->Ways;
+  const Policy *policy = getPolicy(levelConfig->Policy);
+
+  if (level->tags == NULL || level->sets != levelConfig->Sets || level->ways != levelConfig->Ways ||
+      level->blockSize != config->BlockSize || level->tagOnly != config->TagOnly) {
+    freeLines(level);
+
+    /* vector loads of the last set may read TAG_PADDING tags past it */
+    level->tags = calloc(lines + TAG_PADDING, sizeof(uint64_t));
+    level->data = config->TagOnly ? NULL : malloc((size_t)lines * config->BlockSize);
+    level->parkedData = config->TagOnly ? NULL : malloc(config->BlockSize);
+    level->validWays = malloc(levelConfig->Sets * sizeof(uint64_t));
+    level->dirtyWays = malloc(levelConfig->Sets * sizeof(uint64_t));
+    level->sharedWays = malloc(levelConfig->Sets * sizeof(uint64_t));
+    level->lostWays = malloc(levelConfig->Sets * sizeof(uint64_t));
+    level->lostWord = malloc(lines * sizeof(uint32_t));
+    level->prefetchedWays = malloc(levelConfig->Sets * sizeof(uint64_t));
+    level->readyTime = malloc(lines * sizeof(uint64_t));
+    level->pollution = calloc(lines, sizeof(uint64_t));
+    level->pendingWays = malloc(levelConfig->Sets * sizeof(uint64_t));
+    level->setEpoch = calloc(levelConfig->Sets, sizeof(uint32_t));
+    if (level->tags == NULL || (level->data == NULL && !config->TagOnly) ||
+        (level->parkedData == NULL && !config->TagOnly) || level->validWays == NULL ||
+        level->dirtyWays == NULL || level->sharedWays == NULL || level->lostWays == NULL ||
+        level->lostWord == NULL || level->prefetchedWays == NULL || level->readyTime == NULL ||
+        level->pollution == NULL || level->pendingWays == NULL || level->setEpoch == NULL)
+      exit(-1);
+
+    level->lines = lines;
+    level->blockSize = config->BlockSize;
+    level->tagOnly = config->TagOnly;
+    level->epoch = 0;
+    level->policy = NULL;
+    level->prefetcher = NULL;
+  }
+
+  level->sim = sim;
+  level->stats = &sim->stats.level[levelConfig - config->level];
+  level->config = levelConfig;
+  level->offsetBits = config->OffsetBits;
+  level->offsetMask = config->OffsetMask;
+  level->sets = levelConfig->Sets;
+  level->ways = levelConfig->Ways;
+  level->waysMask = levelConfig->Ways == 64 ? ~0ULL : (1ULL << levelConfig->Ways) - 1;
+  level->next = next;
+  level->parked = 0;
+  level->index = levelConfig - config->level;
+  level->core = 0;
+  level->coherent = 0;
+  level->victim = NULL;
+
+  /* pending writes are dropped */
+  if (level->bufferSize != levelConfig->WriteBuffer) {
+    free(level->writeBuffer);
+
+    level->bufferSize = levelConfig->WriteBuffer;
+    level->writeBuffer = malloc((level->bufferSize + 1) * sizeof(uint64_t));
+    if (level->writeBuffer == NULL)
+      exit(-1);
+  }
+
+  level->bufferHead = 0;
+  level->bufferCount = 0;
+  level->bufferBusy = 0;
+
+  /* misses in flight are dropped too */
+  if (level->mshrs != levelConfig->Mshrs) {
+    free(level->mshr);
+
+    level->mshrs = levelConfig->Mshrs;
+    level->mshr = malloc((level->mshrs + 1) * sizeof(uint64_t));
+    if (level->mshr == NULL)
+      exit(-1);
+  }
+
+  if (level->mshr != NULL)
+    memset(level->mshr, 0, level->mshrs * sizeof(uint64_t));
+
+  if (level->policy != policy) {
+    free(level->policyState);
+
+    level->policy = policy;
+    level->policyStride = policy->setSize(level->ways);
+    /* + 1, some policies keep no state per set */
+    level->policyState = malloc((size_t)level->sets * level->policyStride + 1);
+    if (level->policyState == NULL)
+      exit(-1);
+  }
+
+  /* prefetcher state starts over, the pollution filter with each set, see refreshSet() */
+  const Prefetcher *prefetcher = getPrefetcher(levelConfig->Prefetch);
+
+  if (level->prefetcher != prefetcher) {
+    free(level->prefetchState);
+    level->prefetchState = NULL;
+    level->prefetcher = prefetcher;
+
+    if (prefetcher != NULL) {
+      /* + 1, some prefetchers keep no state */
+      level->prefetchState = malloc(prefetcher->stateSize(level) + 1);
+      if (level->prefetchState == NULL)
+        exit(-1);
+    }
+  }
+
+  if (prefetcher != NULL)
+    prefetcher->init(level);
+
+  /* the shadow starts over too, it only costs when classifying */
+  level->classify = config->Classify;
+
+  if (!level->classify)
+    freeShadow(&level->shadow);
+  else if (level->shadow.lines != lines) {
+    freeShadow(&level->shadow);
+    initShadow(&level->shadow, lines);
+  } else
+    resetShadow(&level->shadow);
+
+  /* every set is stale, epoch 0 is never current */
+  if (++level->epoch == 0) {
+    memset(level->setEpoch, 0, level->sets * sizeof(uint32_t));
+    level->epoch = 1;
+  }
+
+  policy->init(level);
+}
+
+/*
+invalidates every way of the set, tags and data are left as is since only
+valid ways are matched and a block is always fetched whole before it is read
+*/
+void refreshSet(Level *level, uint32_t lineIndex) {
+  level->validWays[lineIndex] = 0;
+  level->dirtyWays[lineIndex] = 0;
+  level->sharedWays[lineIndex] = 0;
+  level->lostWays[lineIndex] = 0;
+  level->prefetchedWays[lineIndex] = 0;
+  level->pendingWays[lineIndex] = 0;
+
+  /* the pollution entries of the set's blocks, every sets-th one */
+  if (level->prefetcher != NULL) {
+    for (uint32_t entry = lineIndex; entry < level->lines; entry += level->sets)
+      level->pollution[entry] = 0;
+  }
+
+  level->policy->initSet(level, lineIndex);
+  level->setEpoch[lineIndex] = level->epoch;
+}
+
+/* returns a mask of the ways of a set whose tag is tag, valid or not */
+static inline uint64_t matchTags(const uint64_t *tags, uint32_t ways, uint64_t tag) {
+  uint64_t match = 0;
+
+#if defined(__AVX2__)
+  __m256i key = _mm256_set1_epi64x(tag);
+
+  for (uint32_t way = 0; way < ways; way += 4) {
+    __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(tags + way)), key);
+
+    match |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(equal)) << way;
+  }
+#elif defined(__SSE4_1__)
+  __m128i key = _mm_set1_epi64x(tag);
+
+  for (uint32_t way = 0; way < ways; way += 2) {
+    __m128i equal = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i *)(tags + way)), key);
+
+    match |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(equal)) << way;
+  }
+#else
+  for (uint32_t way = 0; way < ways; way++)
+    match |= (uint64_t)(tags[way] == tag) << way;
+#endif
+
+  return match;
+}
+
+/* moves a whole block between a level and the one below it */
+static void takeBlock(Level *, uint64_t, uint8_t *);
+static void insertBlock(Level *, uint64_t, uint8_t *, uint32_t);
+
+void accessNext(Level *level, uint64_t address, uint8_t *data, uint32_t mode) {
+  /* write backs never carry the access, fills do */
+  if (mode == MODE_READ)
+    passAccess(level->sim, level->index);
+
+  if (level->next == NULL)
+    accessDRAM(level->sim, address, data, mode);
+  else if (level->sim->config.Inclusion != INCLUSION_EXCLUSIVE)
+    accessLevel(level->next, address, data, level->blockSize, mode);
+  else if (mode == MODE_READ)
+    takeBlock(level->next, address, data);
+  else
+    insertBlock(level->next, address, data, 1);
+}
+
+void writeNext(Level *level, uint64_t address, uint8_t *data, uint32_t size) {
+  Simulator *sim = level->sim;
+  uint64_t now = sim->time;
+
+  if (level->next != NULL)
+    accessLevel(level->next, address, data, size, MODE_WRITE);
+  else
+    writeDRAM(sim, address, data, size);
+
+  if (level->bufferSize == 0)
+    return;
+
+  /* the write is done, only its latency goes through the buffer */
+  uint64_t latency = sim->time - now;
+  uint64_t *pending = level->writeBuffer;
+
+  while (level->bufferCount > 0 && pending[level->bufferHead] <= now) {
+    level->bufferHead = (level->bufferHead + 1) % level->bufferSize;
+    level->bufferCount--;
+  }
+
+  /* full, wait for the oldest write */
+  if (level->bufferCount == level->bufferSize) {
+    level->stats->BufferStalls += pending[level->bufferHead] - now;
+    now = pending[level->bufferHead];
+
+    level->bufferHead = (level->bufferHead + 1) % level->bufferSize;
+    level->bufferCount--;
+  }
+
+  level->bufferBusy = (level->bufferBusy > now ? level->bufferBusy : now) + latency;
+  pending[(level->bufferHead + level->bufferCount) % level->bufferSize] = level->bufferBusy;
+  level->bufferCount++;
+
+  sim->time = now;
+}
+
+static void toVictimCache(Level *, uint64_t, uint32_t, uint32_t);
+static void backInvalidate(Level *, uint64_t, uint32_t, uint32_t);
+static void usePrefetched(Level *, uint32_t, uint32_t);
+
+/*
+returns the way to fill in a set, an invalid way if there is one,
+otherwise the policy's victim written back first when dirty. A victim for
+an exclusive next level is parked instead, the fill takes its block out of
+that level first so the victim cannot evict it, then unparkVictim() inserts
+the victim
+*/
+static uint32_t makeRoom(Level *level, uint32_t lineIndex, uint32_t prefetch) {
+  uint64_t invalidWays = ~level->validWays[lineIndex] & level->waysMask;
+  uint32_t way;
+
+  if (invalidWays != 0)
+    return __builtin_ctzll(invalidWays);
+
+  way = level->policy->victim(level, lineIndex);
+  level->stats->Evictions++;
+
+  uint64_t address = getBlockAddress(level, level->tags[lineIndex * level->ways + way], lineIndex);
+
+  if ((level->prefetchedWays[lineIndex] >> way) & 1)
+    level->stats->PrefetchUseless++;
+
+  /* remembered to find the demand misses it causes, see Prefetch.h */
+  if (prefetch)
+    level->pollution[(address >> level->offsetBits) & (level->lines - 1)] = address + 1;
+
+  if (level->sim->config.Inclusion == INCLUSION_INCLUSIVE)
+    backInvalidate(level, address, lineIndex, way);
+
+  if (level->victim != NULL) {
+    toVictimCache(level, address, lineIndex, way);
+    return way;
+  }
+
+  /* the next exclusive level takes every victim, clean or dirty */
+  if (level->sim->config.Inclusion == INCLUSION_EXCLUSIVE && level->next != NULL) {
+    level->parked = address + 1;
+    level->parkedDirty = (level->dirtyWays[lineIndex] >> way) & 1;
+    level->stats->Writebacks += level->parkedDirty;
+
+    if (!level->tagOnly)
+      memcpy(level->parkedData, getLineData(level, lineIndex, way), level->blockSize);
+
+    return way;
+  }
+
+  /* Check if Dirty bit */
+  if ((level->dirtyWays[lineIndex] >> way) & 1) {
+    level->stats->Writebacks++;
+
+    /* Write the evicted block back to where it came from */
+    writeNext(level, address, getLineData(level, lineIndex, way), level->blockSize);
+  }
+
+  return way;
+}
+
+/* swaps the block of an entry and the block of a way, with their dirty bits */
+static void swapVictim(Level *level, uint32_t entry, uint64_t address, uint32_t lineIndex, uint32_t way) {
+  VictimCache *victim = level->victim;
+  uint64_t bit = 1ULL << way;
+  uint8_t dirty = (level->dirtyWays[lineIndex] & bit) != 0;
+
+  if (victim->data != NULL) {
+    memcpy(victim->scratch, getVictimData(victim, entry), level->blockSize);
+    memcpy(getVictimData(victim, entry), getLineData(level, lineIndex, way), level->blockSize);
+    memcpy(getLineData(level, lineIndex, way), victim->scratch, level->blockSize);
+  }
+
+  level->dirtyWays[lineIndex] = (level->dirtyWays[lineIndex] & ~bit) | (victim->dirty[entry] ? bit : 0);
+  victim->blocks[entry] = address + 1;
+  victim->dirty[entry] = dirty;
+  touchVictim(victim, entry);
+}
+
+/* an L1 victim goes to the victim cache, writing back the one it displaces */
+static void toVictimCache(Level *level, uint64_t address, uint32_t lineIndex, uint32_t way) {
+  VictimCache *victim = level->victim;
+  uint32_t entry = getVictimEntry(victim);
+
+  if (victim->blocks[entry] != 0 && victim->dirty[entry]) {
+    level->sim->stats.victim.Writebacks++;
+    level->stats->Writebacks++;
+
+    writeNext(level, victim->blocks[entry] - 1, getVictimData(victim, entry), level->blockSize);
+  }
+
+  victim->dirty[entry] = 0;
+  swapVictim(level, entry, address, lineIndex, way);
+}
+
+/*
+an L1 miss found in the victim cache, returns the way the block was swapped
+into, -1 when it is not there
+*/
+static int fromVictimCache(Level *level, uint64_t address, uint32_t lineIndex) {
+  VictimCache *victim = level->victim;
+  uint64_t block = address & ~(uint64_t)level->offsetMask;
+  int entry = findVictim(victim, block);
+
+  if (entry < 0) {
+    level->sim->stats.victim.Misses++;
+    return -1;
+  }
+
+  level->sim->stats.victim.Hits++;
+
+  uint64_t invalidWays = ~level->validWays[lineIndex] & level->waysMask;
+  uint32_t way;
+
+  /* swap with the L1 victim, or just move over into an invalid way */
+  if (invalidWays != 0) {
+    way = __builtin_ctzll(invalidWays);
+
+    if (victim->data != NULL)
+      memcpy(getLineData(level, lineIndex, way), getVictimData(victim, entry), level->blockSize);
+
+    level->dirtyWays[lineIndex] = (level->dirtyWays[lineIndex] & ~(1ULL << way)) |
+                                  ((uint64_t)victim->dirty[entry] << way);
+    victim->blocks[entry] = 0;
+  } else {
+    way = level->policy->victim(level, lineIndex);
+    level->stats->Evictions++;
+
+    if ((level->prefetchedWays[lineIndex] >> way) & 1)
+      level->stats->PrefetchUseless++;
+
+    swapVictim(level, entry, getBlockAddress(level, level->tags[lineIndex * level->ways + way], lineIndex),
+               lineIndex, way);
+  }
+
+  level->tags[lineIndex * level->ways + way] = getTag(level, block);
+  level->validWays[lineIndex] |= 1ULL << way;
+  level->prefetchedWays[lineIndex] &= ~(1ULL << way);
+  level->pendingWays[lineIndex] &= ~(1ULL << way);
+  level->policy->insert(level, lineIndex, way);
+
+  level->sim->time += level->sim->config.VictimTime;
+
+  return way;
+}
+
+/* exclusive, inserts the victim makeRoom() parked into the next level */
+static void unparkVictim(Level *level) {
+  if (level->parked == 0)
+    return;
+
+  insertBlock(level->next, level->parked - 1, level->parkedData, level->parkedDirty);
+  level->parked = 0;
+}
+
+/* fetches a block into a way made room for, clean and not prefetched */
+static void fillWay(Level *level, uint64_t address, uint32_t lineIndex, uint32_t way, uint64_t matches,
+                    uint32_t mode) {
+  uint64_t bit = 1ULL << way;
+  uint64_t shared = 0;
+
+  /* the other L1s first write back a modified copy, see Coherence.h */
+  if (level->coherent) {
+    shared = snoopMiss(level, address, lineIndex, matches, mode) ? bit : 0;
+    level->lostWays[lineIndex] &= ~(bit | matches);
+  }
+
+  /* an exclusive next level hands over its dirty bit with the block */
+  level->sim->takenDirty = 0;
+  accessNext(level, address, getLineData(level, lineIndex, way), MODE_READ);
+
+  level->tags[lineIndex * level->ways + way] = getTag(level, address);
+
+  level->validWays[lineIndex] |= bit;
+  level->dirtyWays[lineIndex] = (level->dirtyWays[lineIndex] & ~bit) | (level->sim->takenDirty ? bit : 0);
+  level->sharedWays[lineIndex] = (level->sharedWays[lineIndex] & ~bit) | shared;
+  level->prefetchedWays[lineIndex] &= ~bit;
+  level->pendingWays[lineIndex] &= ~bit;
+  level->policy->insert(level, lineIndex, way);
+}
+
+/* forgets a way, its block is elsewhere now */
+static void dropWay(Level *level, uint32_t lineIndex, uint32_t way) {
+  uint64_t bit = ~(1ULL << way);
+
+  /* a prefetched block leaving unused was useless, as on an eviction */
+  if ((level->prefetchedWays[lineIndex] >> way) & 1)
+    level->stats->PrefetchUseless++;
+
+  level->validWays[lineIndex] &= bit;
+  level->dirtyWays[lineIndex] &= bit;
+  level->sharedWays[lineIndex] &= bit;
+  level->prefetchedWays[lineIndex] &= bit;
+  level->pendingWays[lineIndex] &= bit;
+}
+
+/* returns the valid way of a level holding address, -1 if there is none */
+static int findWay(Level *level, uint64_t address, uint32_t lineIndex) {
+  if (level->setEpoch[lineIndex] != level->epoch)
+    refreshSet(level, lineIndex);
+
+  uint64_t hits = matchTags(&level->tags[lineIndex * level->ways], level->ways, getTag(level, address)) &
+                  level->validWays[lineIndex];
+
+  return hits != 0 ? (int)__builtin_ctzll(hits) : -1;
+}
+
+/*
+inclusive, a block leaving a level leaves every level above it too. Dirty
+copies above are newer, they are merged into the line about to be evicted,
+from the lowest level up so the L1 copy is merged last
+*/
+static void backInvalidate(Level *level, uint64_t address, uint32_t lineIndex, uint32_t way) {
+  Simulator *sim = level->sim;
+  uint32_t index = level->config - sim->config.level;
+
+  for (int i = index - 1; i >= 0; i--) {
+    uint32_t copies = i == 0 ? sim->cache.cores : 1;
+
+    for (uint32_t core = 0; core < copies; core++) {
+      Level *upper = i == 0 ? sim->cache.l1[core] : &sim->cache.level[i];
+      uint32_t upperIndex = getLineIndex(upper, address);
+      int upperWay = findWay(upper, address, upperIndex);
+
+      if (upperWay < 0)
+        continue;
+
+      if ((upper->dirtyWays[upperIndex] >> upperWay) & 1) {
+        if (!level->tagOnly)
+          memcpy(getLineData(level, lineIndex, way), getLineData(upper, upperIndex, upperWay), level->blockSize);
+
+        level->dirtyWays[lineIndex] |= 1ULL << way;
+      }
+
+      dropWay(upper, upperIndex, upperWay);
+      level->stats->BackInvalidations++;
+    }
+  }
+}
+
+/* touches the shadow, returns the 3C class a miss of this access has */
+static uint32_t classifyAccess(Level *level, uint64_t address) {
+  if (!level->classify)
+    return MISS_COMPULSORY;
+
+  return accessShadow(&level->shadow, address >> level->offsetBits);
+}
+
+static void countMiss(Level *level, uint32_t mode, uint32_t kind) {
+  level->stats->Misses[mode]++;
+
+  if (!level->classify)
+    return;
+
+  if (kind == MISS_COMPULSORY)
+    level->stats->Compulsory++;
+  else if (kind == MISS_CAPACITY)
+    level->stats->Capacity++;
+  else
+    level->stats->Conflict++;
+}
+
+/*
+exclusive, a block moves up out of a level on a hit. On a miss it comes
+from below without being allocated here
+*/
+static void takeBlock(Level *level, uint64_t address, uint8_t *data) {
+  uint32_t lineIndex = getLineIndex(level, address);
+  int way = findWay(level, address, lineIndex);
+  uint32_t kind = classifyAccess(level, address);
+
+  if (way < 0) {
+    countMiss(level, MODE_READ, kind);
+    accessNext(level, address, data, MODE_READ);
+  } else {
+    level->stats->Hits[MODE_READ]++;
+    serveAccess(level->sim, level->index);
+
+    if ((level->prefetchedWays[lineIndex] >> way) & 1)
+      usePrefetched(level, lineIndex, way);
+
+    if (!level->tagOnly)
+      memcpy(data, getLineData(level, lineIndex, way), level->blockSize);
+
+    level->sim->takenDirty = (level->dirtyWays[lineIndex] >> way) & 1;
+    dropWay(level, lineIndex, way);
+  }
+
+  level->sim->time += level->config->ReadTime;
+}
+
+/* exclusive, a block evicted by the level above moves into this one */
+static void insertBlock(Level *level, uint64_t address, uint8_t *data, uint32_t dirty) {
+  uint32_t lineIndex = getLineIndex(level, address);
+  int way = findWay(level, address, lineIndex);
+  uint64_t bit;
+
+  /* the block is in the level from now on, as far as the shadow goes */
+  classifyAccess(level, address);
+
+  /* a copy is still here when a snoop wrote it back while another L1 kept it */
+  if (way < 0) {
+    way = makeRoom(level, lineIndex, 0);
+    unparkVictim(level);
+    bit = 1ULL << way;
+    level->stats->Fills++;
+
+    /* makeRoom() counted a prefetched victim already */
+    level->prefetchedWays[lineIndex] &= ~bit;
+    dropWay(level, lineIndex, way);
+    level->tags[lineIndex * level->ways + way] = getTag(level, address);
+    level->validWays[lineIndex] |= bit;
+    level->policy->insert(level, lineIndex, way);
+  }
+
+  bit = 1ULL << way;
+
+  if (!level->tagOnly)
+    memcpy(getLineData(level, lineIndex, way), data, level->blockSize);
+
+  if (dirty)
+    level->dirtyWays[lineIndex] |= bit;
+
+  level->sim->time += level->config->WriteTime;
+}
+
+/* a demand access reaching a prefetched block, waits for it if in flight */
+static void usePrefetched(Level *level, uint32_t lineIndex, uint32_t way) {
+  uint64_t ready = level->readyTime[lineIndex * level->ways + way];
+
+  level->prefetchedWays[lineIndex] &= ~(1ULL << way);
+  level->stats->PrefetchUseful++;
+
+  if (ready > level->sim->time) {
+    level->stats->PrefetchLate++;
+    level->sim->time = ready;
+  }
+}
+
+/* a demand miss on a block a prefetch evicted */
+static void checkPollution(Level *level, uint64_t address) {
+  uint64_t block = address & ~(uint64_t)level->offsetMask;
+  uint64_t *entry = &level->pollution[(block >> level->offsetBits) & (level->lines - 1)];
+
+  if (*entry == block + 1) {
+    level->stats->PrefetchPollution++;
+    *entry = 0;
+  }
+}
+
+void prefetchBlock(Level *level, uint64_t address) {
+  Simulator *sim = level->sim;
+  const Config *config = &sim->config;
+  uint32_t lineIndex = getLineIndex(level, address);
+
+  /* dram.size = 0 is the whole address space */
+  if (config->DramSize != 0 && address > config->DramSize - config->BlockSize)
+    return;
+
+  address -= getBlockOffset(level, address);
+
+  if (level->setEpoch[lineIndex] != level->epoch)
+    refreshSet(level, lineIndex);
+
+  uint64_t matches = matchTags(&level->tags[lineIndex * level->ways], level->ways, getTag(level, address));
+  if ((matches & level->validWays[lineIndex]) != 0)
+    return;
+
+  /* a block in the victim cache may be newer than the one below, it comes back on a demand miss */
+  if (level->victim != NULL && findVictim(level->victim, address) >= 0)
+    return;
+
+  /*
+  off the critical path, the block is only ready once the fill is done, also
+  when it waits on an MSHR below. The demand miss it may be issued in keeps
+  its own ready time
+  */
+  uint64_t now = sim->time;
+  uint64_t ready = sim->ready;
+  uint32_t way = makeRoom(level, lineIndex, 1);
+
+  sim->ready = 0;
+  fillWay(level, address, lineIndex, way, 0, MODE_READ);
+  unparkVictim(level);
+
+  level->prefetchedWays[lineIndex] |= 1ULL << way;
+  level->readyTime[lineIndex * level->ways + way] = sim->time > sim->ready ? sim->time : sim->ready;
+  level->stats->Prefetches++;
+
+  sim->time = now;
+  sim->ready = ready;
+}
+
+/*
+takes the MSHR of a miss issued at now that needs latency cycles, waiting
+for the first one to free up when they are all busy. Returns when the
+block arrives
+*/
+static uint64_t takeMshr(Level *level, uint64_t now, uint64_t latency) {
+  Simulator *sim = level->sim;
+  uint32_t first = 0;
+
+  /* free MSHRs completed by now, so the first to complete is free if any is */
+  for (uint32_t i = 1; i < level->mshrs; i++) {
+    if (level->mshr[i] < level->mshr[first])
+      first = i;
+  }
+
+  if (level->mshr[first] > now) {
+    level->stats->MshrStalls += level->mshr[first] - now;
+    now = level->mshr[first];
+    sim->time = now;
+  }
+
+  level->mshr[first] = now + latency;
+  if (level->mshr[first] > sim->drain)
+    sim->drain = level->mshr[first];
+
+  return level->mshr[first];
+}
+
+/* an access to a block still in flight, served by its MSHR */
+static void mergeMiss(Level *level, uint32_t lineIndex, uint32_t way) {
+  uint64_t ready = level->readyTime[lineIndex * level->ways + way];
+
+  if (ready <= level->sim->time) {
+    level->pendingWays[lineIndex] &= ~(1ULL << way);
+    return;
+  }
+
+  level->stats->Merged++;
+  level->sim->ready = ready;
+}
+
+/* Access a level */
+void accessLevel(Level *level, uint64_t address, uint8_t *data, uint32_t size, uint32_t mode) {
+  uint32_t blockOffset = getBlockOffset(level, address);
+  uint32_t lineIndex = getLineIndex(level, address);
+  uint64_t tag = getTag(level, address);
+
+  uint64_t *tags = &level->tags[lineIndex * level->ways];
+  uint32_t way;
+  int victimWay;
+  int allocated = 1;
+  uint32_t event = PREFETCH_ON_HIT;
+
+  if (level->setEpoch[lineIndex] != level->epoch)
+    refreshSet(level, lineIndex);
+
+  uint32_t kind = classifyAccess(level, address);
+
+  /* HIT, if a valid way holds the tag */
+  uint64_t matches = matchTags(tags, level->ways, tag);
+  uint64_t hits = matches & level->validWays[lineIndex];
+
+  if (hits != 0) {
+    way = __builtin_ctzll(hits);
+    level->policy->touch(level, lineIndex, way);
+    level->stats->Hits[mode]++;
+    serveAccess(level->sim, level->index);
+
+    if ((level->prefetchedWays[lineIndex] >> way) & 1) {
+      usePrefetched(level, lineIndex, way);
+      event = PREFETCH_ON_PREFETCHED;
+    }
+
+    if ((level->pendingWays[lineIndex] >> way) & 1)
+      mergeMiss(level, lineIndex, way);
+
+    /* S -> M, the other copies are invalidated */
+    if (level->coherent && mode == MODE_WRITE && ((level->sharedWays[lineIndex] >> way) & 1)) {
+      snoopUpgrade(level, address, lineIndex);
+      level->sharedWays[lineIndex] &= ~(1ULL << way);
+    }
+  }
+
+  /* MISS caught by the victim cache, see Victim.h */
+  else if (level->victim != NULL && (victimWay = fromVictimCache(level, address, lineIndex)) >= 0) {
+    way = victimWay;
+    countMiss(level, mode, kind);
+    serveAccess(level->sim, level->index);
+    event = PREFETCH_ON_MISS;
+  }
+
+  /* MISS without allocation, the write goes to the next level as is */
+  else if (mode == MODE_WRITE && !level->config->WriteAllocate) {
+    countMiss(level, mode, kind);
+    level->stats->Forwards++;
+
+    if (level->coherent) {
+      snoopMiss(level, address, lineIndex, matches, mode);
+      level->lostWays[lineIndex] &= ~matches;
+    }
+
+    if (level->prefetcher != NULL) {
+      checkPollution(level, address);
+      event = PREFETCH_ON_MISS;
+    }
+
+    passAccess(level->sim, level->index);
+    writeNext(level, address, data, size);
+    level->sim->time += level->config->WriteTime;
+    allocated = 0;
+  }
+
+  /* MISS */
+  else {
+    countMiss(level, mode, kind);
+    level->stats->Fills++;
+
+    if (level->prefetcher != NULL) {
+      checkPollution(level, address);
+      event = PREFETCH_ON_MISS;
+    }
+
+    /* non-blocking, the miss only holds an MSHR, see Hierarchy.h */
+    Simulator *sim = level->sim;
+    uint64_t now = sim->time;
+    sim->ready = 0;
+
+    way = makeRoom(level, lineIndex, 0);
+
+    /* Get block of data from the next level */
+    /*
+    You need this for READ and WRITE
+    because if you write you first have to get whole block as well
+    to after only write to certain offset
+    */
+    fillWay(level, address - blockOffset, lineIndex, way, matches, mode);
+    unparkVictim(level);
+
+    /* a blocking level waits for data still in flight below it */
+    uint64_t done = sim->time > sim->ready ? sim->time : sim->ready;
+
+    if (level->mshrs == 0)
+      sim->time = done;
+    else {
+      sim->time = now;
+      sim->ready = takeMshr(level, now, done - now);
+
+      level->readyTime[lineIndex * level->ways + way] = sim->ready;
+      level->pendingWays[lineIndex] |= 1ULL << way;
+    }
+  }
+
+  if (mode == MODE_READ) {
+    if (!level->tagOnly)
+      memcpy(data, getLineData(level, lineIndex, way) + blockOffset, size);
+
+    level->sim->time += level->config->ReadTime;
+  }
+
+  if (mode == MODE_WRITE && allocated) {
+    if (!level->tagOnly)
+      memcpy(getLineData(level, lineIndex, way) + blockOffset, data, size);
+
+    /*Bit to alert cache was written to and hasnt updated memory*/
+    if (!level->config->WriteThrough)
+      level->dirtyWays[lineIndex] |= 1ULL << way;
+    else {
+      level->stats->Forwards++;
+      writeNext(level, address, data, size);
+    }
+
+    level->sim->time += level->config->WriteTime;
+  }
+
+  if (level->prefetcher != NULL)
+    level->prefetcher->access(level, address, event);
+}
+
+/*********************** Interfaces *************************/
+
+/* one timed access, into the latency histogram of the level serving it */
+static void accessTimed(Simulator *sim, Level *l1, uint64_t address, uint8_t *data, uint32_t size,
+                        uint32_t mode) {
+  uint64_t start = sim->time;
+
+  sim->serving = 0;
+  sim->served = 0;
+
+  accessLevel(l1, address, data, size, mode);
+
+  sim->serving = SERVING_DONE;
+  recordLatency(&sim->stats.latency[sim->served][mode], sim->time - start);
+}
+
+void read(Simulator *sim, uint64_t address, uint8_t *data) {
+  accessTimed(sim, &sim->cache.level[0], address, data, WORD_SIZE, MODE_READ);
+}
+
+void write(Simulator *sim, uint64_t address, uint8_t *data) {
+  accessTimed(sim, &sim->cache.level[0], address, data, WORD_SIZE, MODE_WRITE);
+}
+
+void readCore(Simulator *sim, uint32_t core, uint64_t address, uint8_t *data) {
+  accessTimed(sim, sim->cache.l1[core], address, data, WORD_SIZE, MODE_READ);
+}
+
+void writeCore(Simulator *sim, uint32_t core, uint64_t address, uint8_t *data) {
+  accessTimed(sim, sim->cache.l1[core], address, data, WORD_SIZE, MODE_WRITE);
+}
+
+void readBytes(Simulator *sim, uint32_t core, uint64_t address, uint8_t *data, uint32_t size) {
+  accessTimed(sim, sim->cache.l1[core], address, data, size, MODE_READ);
+}
+
+void writeBytes(Simulator *sim, uint32_t core, uint64_t address, uint8_t *data, uint32_t size) {
+  accessTimed(sim, sim->cache.l1[core], address, data, size, MODE_WRITE);
+}
@@ -0,0 +1,275 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "Cache.h"
+#include "Config.h"
+#include "Policy.h"
+#include "Prefetch.h"
+#include "Shadow.h"
+#include "Victim.h"
+#include "Memory.h"
+#include "Stats.h"
+
+/*
+Generic cache hierarchy
+
+Every level is the same set associative engine, parameterized by the
+LevelConfig of its geometry and latencies, and forwards its misses and
+write backs to the next level (the last one to DRAM):
+
+  read/write -> L1 -> L2 -> ... -> Ln -> DRAM
+
+A direct mapped cache is a level with a single way. The number of levels
+and their geometry come from Config.h, so the 4.1, 4.2 and 4.3 programs
+are the same engine with different defaults in their Cache.h.
+
+All state lives in a Simulator (see below), any number of them can run
+side by side, one thread each. Addresses are 64 bits, DRAM is sparse (see
+Memory.h) so traces may touch any part of the address space.
+
+Resets are constant time: initCache() only starts a new epoch. A set is
+emptied the first time it is used in a new epoch (refreshSet) and a DRAM
+page is zeroed the first time it is accessed (resetMemory), so the cost of a reset is
+paid by the sets and pages that are actually used again.
+
+With cores > 1 every core gets a private L1 and the levels below are
+shared, the L1s are kept coherent with MESI (see Coherence.h):
+
+  read/write(core) -> L1[core] -> L2 -> ... -> Ln -> DRAM
+
+An optional victim cache catches the blocks L1 evicts (see Victim.h):
+
+  read/write -> L1 (-> victim cache) -> L2 -> ... -> Ln -> DRAM
+
+Levels are write back and write allocate unless configured otherwise (see
+Config.h). A write through level forwards every write to the next level
+and never holds dirty lines, a level without write allocation forwards
+write misses without filling. Those writes and the dirty write backs go
+through the level's write buffer when it has one: they take effect at
+once, but their latency is only paid when the buffer is full. The buffer
+drains one write at a time, in order, each taking the latency it would
+have had unbuffered.
+
+Levels are non-inclusive non-exclusive (NINE) by default: a fill
+allocates at every level on the way and an eviction only concerns its
+own level. With inclusion = inclusive a level evicting a block also
+invalidates it in every level above (back-invalidation), merging their
+dirty data first. With inclusion = exclusive a level only holds blocks
+the level above does not: a hit hands the block, and its dirty bit, up to
+the level above and drops it, a miss passes the block through without
+allocating, and every block the level above evicts, clean or dirty, is
+inserted once the block it made room for has left, so the two swap. The last level still writes back to DRAM only dirty blocks.
+Only L1 is ever accessed in place, the levels below it just trade blocks,
+so they can have neither MSHRs nor a prefetcher. An inserted block counts
+as an access for the shadow of classify = 1.
+
+A level with MSHRs (l<n>.mshrs) is non-blocking: a miss takes an MSHR and
+the access moves on at once, paying only the level's own latency, while
+the block arrives once the miss latency has passed. An access to a block
+still in flight merges into its MSHR and when every MSHR is busy the
+access waits for the first one to free up. Misses are simulated at once
+like the write buffer does, only their latency overlaps. The time then
+runs ahead of the data, getTime() is when every miss issued so far is done.
+
+Tag only mode (tag_only = 1) keeps no block data and no DRAM: lines hold
+only their tag, valid, dirty and replacement state and accesses only move
+the clock. Hit/miss counts and times are those of the full engine, read
+leaves its buffer untouched.
+
+Every read() and write() is timed into a latency histogram of the level
+that served it (see Stats.h). The access carries its level down as it
+misses (sim->serving), only the fill it needs takes it further, so write
+backs, snoops and prefetches on the way never claim it.
+
+With classify = 1 every level also runs its accesses through a shadow
+fully associative LRU cache to split its misses into compulsory, capacity
+and conflict ones (see Shadow.h).
+*/
+
+#define DRAM_PAGE_BITS 12 /* lazily zeroed in pages of 4 KiB, or a block */
+#define TAG_PADDING 4     /* tags read past the last set by one vector load */
+
+struct Simulator;
+
+/*********************** Level *************************/
+
+/*
+sets = size / block size / ways
+
+lines are kept as a structure of arrays: the tags of a set are next to
+each other, set i starts at tags[i * ways], and its valid and dirty bits
+are the masks validWays[i] and dirtyWays[i], bit w for way w. A lookup
+compares all the tags of a set at once (with AVX2 or SSE4.1 when the
+compiler targets them) and keeps the valid matches, invalid ways are found
+without looking at the tags at all. The masks only hold when
+setEpoch[i] == epoch, see refreshSet()
+
+the private L1s of a multi-core simulator (coherent) also keep which ways
+are shared and which were lost to another core's write, see Coherence.h,
+and every level which ways hold prefetched blocks, see Prefetch.h
+*/
+typedef struct Level {
+  struct Simulator *sim;
+  const LevelConfig *config;
+  uint32_t sets;
+  uint32_t ways;
+  uint32_t lines;       /* sets * ways */
+  uint32_t blockSize;
+  uint32_t offsetBits;
+  uint32_t offsetMask;
+  uint32_t tagOnly;     /* data is NULL */
+  uint64_t *tags;       /* lines tags, padded for vector loads */
+  uint64_t *validWays;  /* one mask per set */
+  uint64_t *dirtyWays;  /* one mask per set */
+  uint64_t *sharedWays; /* one mask per set, MESI S */
+  uint64_t *lostWays;   /* one mask per set, invalidated by another core */
+  uint32_t *lostWord;   /* per line, word written by that core */
+  uint64_t *prefetchedWays; /* one mask per set, prefetched and not used yet */
+  uint64_t *readyTime;  /* per line, when a prefetched or pending block arrives */
+  uint64_t *pendingWays; /* one mask per set, misses in flight */
+  uint64_t *pollution;  /* lines entries, blocks evicted by prefetches + 1 */
+  uint8_t *data;        /* lines * BlockSize bytes, line i at i * BlockSize */
+  /* exclusive, the victim of a fill waits here until the block came up, see makeRoom() */
+  uint64_t parked;      /* its address + 1, 0 for none */
+  uint32_t parkedDirty;
+  uint8_t *parkedData;  /* BlockSize bytes, NULL in tag only mode */
+  uint64_t waysMask;    /* one bit per way */
+  LevelStats *stats;    /* in the simulator's Stats */
+  uint32_t epoch;       /* bumped by every initLevel */
+  uint32_t *setEpoch;   /* epoch each set was last emptied in */
+  struct Level *next;   /* NULL when the next level is DRAM */
+  /* write buffer, completion times of the pending writes, oldest first */
+  uint64_t *writeBuffer;
+  uint32_t bufferSize;
+  uint32_t bufferHead;
+  uint32_t bufferCount;
+  uint64_t bufferBusy;  /* when the last pending write completes */
+
+  /* MSHRs, when each of the misses in flight completes */
+  uint64_t *mshr;
+  uint32_t mshrs;
+
+  uint32_t index;       /* 0 for the L1s */
+  uint32_t core;        /* owner of a private L1 */
+  uint32_t coherent;    /* private L1 with cores > 1 */
+
+  /* replacement, see Policy.h */
+  const Policy *policy;
+  uint8_t *policyState; /* sets * policyStride bytes */
+  uint32_t policyStride;
+  uint32_t policyCounter;
+
+  VictimCache *victim;   /* behind L1, NULL for none */
+
+  /* prefetching, see Prefetch.h, NULL for none */
+  const struct Prefetcher *prefetcher;
+  uint8_t *prefetchState;
+
+  /* 3C miss classification, see Shadow.h */
+  uint32_t classify;
+  ShadowCache shadow;
+} Level;
+
+void initLevel(struct Simulator *, Level *, const LevelConfig *, Level *);
+
+/* empties a set left over from an earlier epoch */
+void refreshSet(Level *, uint32_t);
+
+/************************ Utils ************************/
+uint32_t getBlockOffset(const Level *, uint64_t);
+uint32_t getLineIndex(const Level *, uint64_t);
+uint64_t getTag(const Level *, uint64_t);
+uint64_t getBlockAddress(const Level *, uint64_t, uint32_t);
+
+/* returns the block of a way, NULL in tag only mode */
+static inline uint8_t *getLineData(const Level *level, uint32_t lineIndex, uint32_t way) {
+  if (level->data == NULL)
+    return NULL;
+
+  return level->data + (((size_t)lineIndex * level->ways + way) << level->offsetBits);
+}
+
+/* moves a whole block between a level and the one below it */
+void accessNext(Level *, uint64_t, uint8_t *, uint32_t);
+
+/* writes size bytes to the level below, through the write buffer */
+void writeNext(Level *, uint64_t, uint8_t *, uint32_t);
+
+/* accesses size bytes at address, size <= BlockSize and within one block */
+void accessLevel(Level *, uint64_t, uint8_t *, uint32_t, uint32_t);
+
+/*********************** Cache *************************/
+
+typedef struct Cache {
+  uint32_t levels;
+  uint32_t cores;
+  Level level[MAX_LEVELS];
+  Level *l1[MAX_CORES];             /* l1[0] is level[0] */
+  Level privateL1[MAX_CORES - 1];   /* the L1s of cores 1 .. cores - 1 */
+} Cache;
+
+/*********************** Simulator *************************/
+
+/*
+one independent simulation: its own copy of the configuration, DRAM, clock
+and cache. The levels point into it, so a Simulator must not be moved or
+copied once initialized
+*/
+typedef struct Simulator {
+  Config config;
+  Memory DRAM;          /* no pages are touched in tag only mode */
+  uint64_t pageMask;
+  uint64_t time;        /* in cycles, 64 bits so long traces never wrap */
+  uint64_t ready;       /* when the data of a non-blocking miss arrives */
+  uint64_t drain;       /* when every miss in flight is done */
+  uint32_t takenDirty;  /* dirty bit of a block taken from an exclusive level */
+  /* level the current read() or write() has reached, levels for DRAM, see serveAccess() */
+  uint32_t serving;
+  uint32_t served;
+  Cache cache;
+  VictimCache victim;   /* used when victim.entries > 0 */
+  Stats stats;
+} Simulator;
+
+/*
+copies config (getConfig() when NULL) and initializes the cache, free a
+simulator before initializing it again with another config
+*/
+int initSimulator(Simulator *, const Config *);
+void freeSimulator(Simulator *);
+
+void resetTime(Simulator *);
+
+uint64_t getTime(const Simulator *);
+
+/****************  RAM memory (byte addressable) ***************/
+void accessDRAM(Simulator *, uint64_t, uint8_t *, uint32_t);
+
+/* writes size bytes within one block */
+void writeDRAM(Simulator *, uint64_t, uint8_t *, uint32_t);
+void initDRAM(Simulator *);
+
+/* empties every level and zeroes DRAM */
+void initCache(Simulator *);
+
+/*********************** Interfaces *************************/
+
+void read(Simulator *, uint64_t, uint8_t *);
+
+void write(Simulator *, uint64_t, uint8_t *);
+
+/* read() and write() are core 0 */
+void readCore(Simulator *, uint32_t, uint64_t, uint8_t *);
+
+void writeCore(Simulator *, uint32_t, uint64_t, uint8_t *);
+
+/* size bytes of core at address, within one block, the others are a word */
+void readBytes(Simulator *, uint32_t, uint64_t, uint8_t *, uint32_t);
+
+void writeBytes(Simulator *, uint32_t, uint64_t, uint8_t *, uint32_t);
+
+#endif
@@ -0,0 +1,126 @@
+#include "Memory.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_SIZE (1 << MEMORY_RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+
+/**************** Utils ***************/
+
+static void *allocNode(size_t size) {
+  void *node = calloc(RADIX_SIZE, size);
+  if (node == NULL)
+    exit(-1);
+
+  return node;
+}
+
+/* takes one page out of the last slab, opening a new slab when it is used up */
+static uint8_t *allocPage(Memory *memory) {
+  size_t pageSize = (size_t)1 << memory->pageBits;
+
+  if (memory->slabFree == 0) {
+    if (memory->slabs == memory->slabCapacity) {
+      memory->slabCapacity = memory->slabCapacity ? 2 * memory->slabCapacity : 16;
+      memory->slab = realloc(memory->slab, memory->slabCapacity * sizeof(uint8_t *));
+      if (memory->slab == NULL)
+        exit(-1);
+    }
+
+    /* calloc, large slabs come straight from the OS already zeroed */
+    memory->slab[memory->slabs] = calloc(MEMORY_SLAB_PAGES, pageSize);
+    if (memory->slab[memory->slabs] == NULL)
+      exit(-1);
+
+    memory->slabs++;
+    memory->slabFree = MEMORY_SLAB_PAGES;
+  }
+
+  memory->slabFree--;
+  memory->pages++;
+
+  return memory->slab[memory->slabs - 1] + (size_t)memory->slabFree * pageSize;
+}
+
+static void freeNode(void **node, uint32_t depth) {
+  if (node == NULL)
+    return;
+
+  if (depth > 1) {
+    for (uint32_t i = 0; i < RADIX_SIZE; i++)
+      freeNode(node[i], depth - 1);
+  }
+
+  free(node);
+}
+
+/**************** Memory ***************/
+
+void initMemory(Memory *memory, uint32_t pageBits) {
+  memset(memory, 0, sizeof(Memory));
+
+  memory->pageBits = pageBits;
+  memory->depth = (64 - pageBits + MEMORY_RADIX_BITS - 1) / MEMORY_RADIX_BITS;
+  memory->epoch = 1;
+}
+
+void freeMemory(Memory *memory) {
+  freeNode(memory->root, memory->depth);
+
+  for (uint32_t i = 0; i < memory->slabs; i++)
+    free(memory->slab[i]);
+  free(memory->slab);
+
+  memset(memory, 0, sizeof(Memory));
+}
+
+void resetMemory(Memory *memory) {
+  memory->lastData = NULL;
+
+  /* epoch 0 is never current, on wrap around start over with no pages */
+  if (++memory->epoch == 0) {
+    uint32_t pageBits = memory->pageBits;
+
+    freeMemory(memory);
+    initMemory(memory, pageBits);
+  }
+}
+
+uint8_t *getMemoryPage(Memory *memory, uint64_t address) {
+  uint64_t page = address >> memory->pageBits;
+
+  if (memory->lastData != NULL && memory->lastPage == page)
+    return memory->lastData;
+
+  if (memory->root == NULL)
+    memory->root = allocNode(sizeof(void *));
+
+  /* walk down the table, top bits first */
+  void **node = memory->root;
+  uint32_t shift = (memory->depth - 1) * MEMORY_RADIX_BITS;
+
+  for (uint32_t level = 1; level < memory->depth; level++, shift -= MEMORY_RADIX_BITS) {
+    void **child = &node[(page >> shift) & RADIX_MASK];
+
+    if (*child == NULL)
+      *child = allocNode(level + 1 < memory->depth ? sizeof(void *) : sizeof(MemoryPage));
+
+    node = *child;
+  }
+
+  MemoryPage *entry = &((MemoryPage *)node)[page & RADIX_MASK];
+
+  if (entry->Data == NULL) {
+    entry->Data = allocPage(memory);
+  } else if (entry->Epoch != memory->epoch) {
+    memset(entry->Data, 0, (size_t)1 << memory->pageBits);
+  }
+
+  entry->Epoch = memory->epoch;
+
+  memory->lastPage = page;
+  memory->lastData = entry->Data;
+
+  return entry->Data;
+}
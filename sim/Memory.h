@@ -0,0 +1,57 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdint.h>
+
+/*
+Sparse byte addressable memory, the backing store of DRAM
+
+The 64 bit address space is split into pages of 2^pageBits bytes, found
+through a radix table of MEMORY_RADIX_BITS bits per level:
+
+  address = | index[0] | index[1] | ... | index[depth - 1] | page offset |
+
+Only the table nodes and pages on the path of an accessed address exist,
+so memory use follows the touched footprint, not the address range. Pages
+are carved out of MEMORY_SLAB_PAGES sized slabs.
+
+resetMemory() is constant time like initCache(): it starts a new epoch and
+every page is zeroed again on its first access in that epoch.
+*/
+
+#define MEMORY_RADIX_BITS 9
+#define MEMORY_SLAB_PAGES 256
+
+typedef struct MemoryPage {
+  uint8_t *Data;
+  uint32_t Epoch;       /* the epoch Data was last zeroed in */
+} MemoryPage;
+
+typedef struct Memory {
+  uint32_t pageBits;
+  uint32_t depth;       /* table levels, the last one holds MemoryPages */
+  uint32_t epoch;
+  void **root;
+  uint64_t pages;       /* allocated so far */
+
+  /* page most recently looked up, NULL when stale */
+  uint64_t lastPage;
+  uint8_t *lastData;
+
+  /* slabs pages are carved from */
+  uint8_t **slab;
+  uint32_t slabs;
+  uint32_t slabCapacity;
+  uint32_t slabFree;    /* pages left in the last slab */
+} Memory;
+
+void initMemory(Memory *, uint32_t);
+void freeMemory(Memory *);
+
+/* forgets every value, the memory reads as zeroes again */
+void resetMemory(Memory *);
+
+/* returns the page holding address, allocated and zeroed as needed */
+uint8_t *getMemoryPage(Memory *, uint64_t);
+
+#endif
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Config.h"
+#include "StackDistance.h"
+#include "Trace.h"
+
+/*
+Miss ratio curves, LRU misses of every power of two cache geometry in one
+pass over a trace (see StackDistance.h)
+
+  MissCurve [-c <config>] [-s <key>=<value>]... [-S <max sets>] [-M <max size>]
+            [-r <rate>] [-n <max blocks>] <trace>
+
+  -c, -s  as for TraceProgram, only block_size matters here
+  -S      largest set count to track, 4096 by default
+  -M      largest cache size to report in bytes, 4 MiB by default
+  -r      sample blocks at this rate, e.g. 0.01, exact by default
+  -n      sample at most this many blocks at a time, the rate then
+          starts at -r (or 1) and drops as needed
+
+prints one csv row per geometry, sets = 1 being fully associative, sampled
+misses are estimates:
+
+  sets,ways,size,accesses,misses,miss_ratio
+*/
+
+static void usage() {
+  fprintf(stderr, "usage: MissCurve [-c <config>] [-s <key>=<value>]... "
+                  "[-S <max sets>] [-M <max size>] [-r <rate>] [-n <max blocks>] <trace>\n");
+  exit(-1);
+}
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  uint32_t maxSets = 4096;
+  uint64_t maxSize = 4 << 20;
+  double rate = 1;
+  uint32_t maxBlocks = 0;
+  Config config;
+
+  defaultConfig(&config);
+
+  for (int i = 1; i < argc - 1; i++) {
+    if (strcmp(argv[i], "-c") == 0 && loadConfig(&config, argv[i + 1]) < 0)
+      return -1;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+      i++;
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      if (parseConfigOption(&config, argv[++i]) < 0)
+        return -1;
+    }
+    else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+      maxSets = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc)
+      maxSize = strtoull(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      rate = strtod(argv[++i], NULL);
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      maxBlocks = strtoul(argv[++i], NULL, 0);
+    else if (argv[i][0] != '-' && path == NULL)
+      path = argv[i];
+    else
+      usage();
+  }
+
+  if (path == NULL)
+    usage();
+
+  if (finalizeConfig(&config) < 0)
+    return -1;
+
+  StackDistance sd;
+  if (initStackDistance(&sd, config.OffsetBits, maxSets) < 0)
+    return -1;
+
+  if ((rate != 1 || maxBlocks != 0) && setStackSampling(&sd, rate, maxBlocks) < 0)
+    return -1;
+
+  Trace trace;
+  if (openTrace(&trace, path) < 0)
+    return -1;
+
+  for (uint64_t n = 0; n < trace.count; n++) {
+    const TraceRecord *record = traceRecord(&trace, n);
+
+    if (record->Op == TRACE_RESET) {
+      resetStackDistance(&sd);
+      continue;
+    }
+
+    /* one access per block the record covers, like TraceProgram */
+    uint64_t block;
+    uint32_t blocks = traceBlocks(record, config.OffsetBits, &block);
+
+    for (uint32_t b = 0; b < blocks; b++, block += config.BlockSize)
+      accessStackDistance(&sd, block);
+  }
+
+  closeTrace(&trace);
+
+  printf("sets,ways,size,accesses,misses,miss_ratio\n");
+
+  for (uint32_t sets = 1; sets <= maxSets; sets *= 2) {
+    for (uint64_t ways = 1; sets * ways * config.BlockSize <= maxSize; ways *= 2) {
+      double ratio = getStackMissRatio(&sd, sets, ways);
+
+      printf("%u,%llu,%llu,%llu,%.0f,%.6f\n", sets, (unsigned long long)ways,
+             (unsigned long long)(sets * ways * config.BlockSize),
+             (unsigned long long)sd.accesses, ratio * sd.accesses, ratio);
+    }
+  }
+
+  freeStackDistance(&sd);
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Belady.h"
+#include "Hierarchy.h"
+#include "Trace.h"
+
+/*
+Replacement headroom, misses of the configured policy next to Belady's
+optimal policy (see Belady.h) at the same geometry
+
+  Opt [-c <config>] [-s <key>=<value>]... [-l <level>] <trace>
+
+  -c, -s  as for TraceProgram
+  -l      level whose geometry and policy are compared, 1 by default
+
+Both caches see the trace directly, as a single write back write allocate
+level in tag only mode (no prefetcher, write buffer or MSHRs), so the gap
+is what replacement alone could still win at that size. Prints:
+
+  policy,sets,ways,size,accesses,misses,miss_ratio
+*/
+
+static void usage() {
+  fprintf(stderr, "usage: Opt [-c <config>] [-s <key>=<value>]... [-l <level>] <trace>\n");
+  exit(-1);
+}
+
+/* the level alone, as Belady sees it */
+static void levelOnly(Config *config, uint32_t level) {
+  config->level[0] = config->level[level];
+  config->level[0].WriteThrough = 0;
+  config->level[0].WriteAllocate = 1;
+  config->level[0].WriteBuffer = 0;
+  config->level[0].Prefetch = PREFETCH_NONE;
+  config->level[0].Mshrs = 0;
+
+  config->Levels = 1;
+  config->TagOnly = 1;
+  config->DramSize = 0;
+  config->Cores = 1;
+  config->Inclusion = INCLUSION_NINE;
+  config->VictimEntries = 0;
+}
+
+static void printRow(const char *policy, const LevelConfig *level, uint64_t accesses, uint64_t misses) {
+  printf("%s,%u,%u,%llu,%llu,%llu,%.6f\n", policy, level->Sets, level->Ways,
+         (unsigned long long)level->Size, (unsigned long long)accesses, (unsigned long long)misses,
+         accesses != 0 ? (double)misses / accesses : 0);
+}
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  uint32_t level = 1;
+  Config config;
+
+  defaultConfig(&config);
+
+  for (int i = 1; i < argc - 1; i++) {
+    if (strcmp(argv[i], "-c") == 0 && loadConfig(&config, argv[i + 1]) < 0)
+      return -1;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+      i++;
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      if (parseConfigOption(&config, argv[++i]) < 0)
+        return -1;
+    }
+    else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+      level = strtoul(argv[++i], NULL, 0);
+    else if (argv[i][0] != '-' && path == NULL)
+      path = argv[i];
+    else
+      usage();
+  }
+
+  if (path == NULL)
+    usage();
+
+  if (finalizeConfig(&config) < 0)
+    return -1;
+
+  if (level < 1 || level > config.Levels) {
+    fprintf(stderr, "config: level %u out of 1..%u\n", level, config.Levels);
+    return -1;
+  }
+
+  levelOnly(&config, level - 1);
+
+  Simulator sim;
+  if (initSimulator(&sim, &config) < 0)
+    return -1;
+
+  Trace trace;
+  if (openTrace(&trace, path) < 0)
+    return -1;
+
+  uint64_t accesses;
+  uint32_t *next = findNextUses(&trace, sim.config.OffsetBits, &accesses);
+  if (next == NULL)
+    return -1;
+
+  Belady belady;
+  initBelady(&belady, &sim.config.level[0], sim.config.OffsetBits);
+
+  uint64_t i = 0;
+
+  for (uint64_t n = 0; n < trace.count; n++) {
+    const TraceRecord *record = traceRecord(&trace, n);
+
+    if (record->Op == TRACE_RESET) {
+      resetTime(&sim);
+      initCache(&sim);
+      resetBelady(&belady);
+      continue;
+    }
+
+    /* split at blocks like TraceProgram, next uses are numbered the same way */
+    uint64_t block, start = record->Address, end = start + traceSize(record);
+    uint32_t blocks = traceBlocks(record, sim.config.OffsetBits, &block);
+    uint8_t data[256]; /* tag only, never touched */
+
+    for (uint32_t b = 0; b < blocks; b++, block += sim.config.BlockSize) {
+      uint64_t address = start > block ? start : block;
+      uint32_t size = (uint32_t)((end < block + sim.config.BlockSize ? end : block + sim.config.BlockSize) - address);
+
+      if (record->Op == TRACE_WRITE)
+        writeBytes(&sim, 0, address, data, size);
+      else
+        readBytes(&sim, 0, address, data, size);
+
+      accessBelady(&belady, address, next[i++]);
+    }
+  }
+
+  closeTrace(&trace);
+
+  const LevelStats *stats = &sim.stats.level[0];
+  const char *policy = getPolicy(sim.config.level[0].Policy)->Name;
+
+  printf("policy,sets,ways,size,accesses,misses,miss_ratio\n");
+  printRow(policy, &sim.config.level[0], accesses, stats->Misses[0] + stats->Misses[1]);
+  printRow("opt", &sim.config.level[0], belady.accesses, belady.misses);
+
+  freeBelady(&belady);
+  free(next);
+  freeSimulator(&sim);
+
+  return 0;
+}
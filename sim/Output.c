@@ -0,0 +1,214 @@
+#include "Output.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Trace.h"
+
+/**************** Utils ***************/
+
+static int hasSuffix(const char *path, const char *suffix) {
+  size_t length = strlen(path), suffixLength = strlen(suffix);
+
+  return length > suffixLength && strcmp(path + length - suffixLength, suffix) == 0;
+}
+
+static void flushOutput(Output *output) {
+  fwrite(output->buffer, 1, output->used, output->file);
+  output->used = 0;
+}
+
+/* appends the decimal digits of value, printf's %llu without printf */
+static char *appendUnsigned(char *to, uint64_t value) {
+  char digits[20];
+  int n = 0;
+
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+
+  while (n > 0)
+    *to++ = digits[--n];
+
+  return to;
+}
+
+/* printf's %d */
+static char *appendInt(char *to, int32_t value) {
+  if (value < 0) {
+    *to++ = '-';
+    return appendUnsigned(to, -(int64_t)value);
+  }
+
+  return appendUnsigned(to, value);
+}
+
+static char *appendString(char *to, const char *text) {
+  size_t length = strlen(text);
+
+  memcpy(to, text, length);
+  return to + length;
+}
+
+/*
+starts gzip writing to path and returns a pipe into it, NULL on failure.
+gzip gets the path as an open file, no shell ever sees it
+*/
+static FILE *openGzip(const char *path, pid_t *child) {
+  FILE *file = fopen(path, "wb");
+  int fds[2];
+
+  if (file == NULL)
+    return NULL;
+
+  if (pipe(fds) != 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  *child = fork();
+
+  if (*child == 0) {
+    if (dup2(fds[0], STDIN_FILENO) < 0 || dup2(fileno(file), STDOUT_FILENO) < 0)
+      _exit(127);
+
+    close(fds[0]);
+    close(fds[1]);
+    fclose(file);
+    execlp("gzip", "gzip", "-c", (char *)NULL);
+    _exit(127);
+  }
+
+  close(fds[0]);
+  fclose(file);
+
+  if (*child < 0) {
+    close(fds[1]);
+    return NULL;
+  }
+
+  FILE *stream = fdopen(fds[1], "wb");
+
+  if (stream == NULL) {
+    close(fds[1]);
+    waitpid(*child, NULL, 0);
+  }
+
+  return stream;
+}
+
+/* closes the pipe and waits for gzip, -1 unless it exited cleanly */
+static int closeGzip(FILE *stream, pid_t child) {
+  int status, failed = fclose(stream) != 0;
+
+  while (waitpid(child, &status, 0) < 0) {
+    if (errno != EINTR)
+      return -1;
+  }
+
+  return failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ? -1 : 0;
+}
+
+/**************** Output ***************/
+
+int openOutput(Output *output, const char *path) {
+  memset(output, 0, sizeof(Output));
+
+  if (path == NULL)
+    return 0;
+
+  if (strcmp(path, "-") == 0) {
+    output->kind = OUTPUT_TEXT;
+    output->file = stdout;
+  } else if (hasSuffix(path, ".gz")) {
+    output->kind = OUTPUT_GZIP;
+    output->file = openGzip(path, &output->gzip);
+  } else {
+    output->kind = hasSuffix(path, ".bin") ? OUTPUT_BINARY : OUTPUT_TEXT;
+    output->file = fopen(path, "wb");
+  }
+
+  output->buffer = malloc(OUTPUT_BUFFER);
+  if (output->file == NULL || output->buffer == NULL) {
+    fprintf(stderr, "output: cannot open %s\n", path);
+    free(output->buffer);
+    return -1;
+  }
+
+  /* placeholder, the count is only known once closed */
+  if (output->kind == OUTPUT_BINARY) {
+    OutputHeader header = {OUTPUT_MAGIC, OUTPUT_VERSION, sizeof(OutputRecord), 0};
+
+    fwrite(&header, sizeof(header), 1, output->file);
+  }
+
+  return 0;
+}
+
+int closeOutput(Output *output) {
+  int failed = 0;
+
+  if (output->kind == OUTPUT_NONE)
+    return 0;
+
+  flushOutput(output);
+
+  if (output->kind == OUTPUT_BINARY) {
+    OutputHeader header = {OUTPUT_MAGIC, OUTPUT_VERSION, sizeof(OutputRecord), output->count};
+
+    failed = fseek(output->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, output->file) != 1;
+  }
+
+  failed |= ferror(output->file) != 0;
+
+  if (output->kind == OUTPUT_GZIP)
+    failed |= closeGzip(output->file, output->gzip) != 0;
+  else if (output->file == stdout)
+    failed |= fflush(stdout) != 0;
+  else
+    failed |= fclose(output->file) != 0;
+
+  free(output->buffer);
+  memset(output, 0, sizeof(Output));
+
+  if (failed) {
+    fprintf(stderr, "output: write failed\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+void writeOutput(Output *output, uint8_t op, uint64_t address, uint32_t value, uint64_t time) {
+  if (output->kind == OUTPUT_NONE)
+    return;
+
+  /* the longest text line is well under 128 bytes */
+  if (output->used + 128 > OUTPUT_BUFFER)
+    flushOutput(output);
+
+  output->count++;
+
+  if (output->kind == OUTPUT_BINARY) {
+    OutputRecord record = {address, time, value, op, {0}};
+
+    memcpy(output->buffer + output->used, &record, sizeof(record));
+    output->used += sizeof(record);
+    return;
+  }
+
+  char *to = output->buffer + output->used;
+
+  to = appendString(to, op == TRACE_WRITE ? "Write; Address " : "Read; Address ");
+  to = appendUnsigned(to, address);
+  to = appendString(to, "; Value ");
+  to = appendInt(to, (int32_t)value);
+  to = appendString(to, "; Time ");
+  to = appendUnsigned(to, time);
+  *to++ = '\n';
+
+  output->used = to - output->buffer;
+}
@@ -0,0 +1,60 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+Per access output sinks
+
+Accesses are formatted into a large buffer that is written out whole, so
+replaying a trace is not bound by one stdio call per access.
+
+  OUTPUT_NONE    nothing, only the summary is printed
+  OUTPUT_TEXT    the SimpleProgram.c lines, "Read; Address a; Value v; Time t"
+  OUTPUT_GZIP    the same text piped through a gzip child writing the file
+  OUTPUT_BINARY  an OutputHeader followed by fixed-size OutputRecords, little
+                 endian like traces (see Trace.h)
+*/
+
+#define OUTPUT_NONE 0
+#define OUTPUT_TEXT 1
+#define OUTPUT_GZIP 2
+#define OUTPUT_BINARY 3
+
+#define OUTPUT_MAGIC "CLOG"
+#define OUTPUT_VERSION 2
+#define OUTPUT_BUFFER (1 << 20)
+
+typedef struct OutputHeader {
+  char Magic[4];
+  uint16_t Version;
+  uint16_t RecordSize;
+  uint64_t Count;
+} OutputHeader;
+
+typedef struct OutputRecord {
+  uint64_t Address;
+  uint64_t Time;      /* getTime() after the access */
+  uint32_t Value;
+  uint8_t Op;         /* TRACE_READ or TRACE_WRITE */
+  uint8_t Reserved[3];
+} OutputRecord;
+
+typedef struct Output {
+  int kind;
+  FILE *file;
+  pid_t gzip;         /* OUTPUT_GZIP, the child compressing file */
+  char *buffer;
+  size_t used;
+  uint64_t count;
+} Output;
+
+/* picks the kind from the name: - is text to stdout, .gz and .bin by suffix */
+int openOutput(Output *, const char *);
+int closeOutput(Output *);
+
+void writeOutput(Output *, uint8_t, uint64_t, uint32_t, uint64_t);
+
+#endif
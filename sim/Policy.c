@@ -0,0 +1,251 @@
+#include "Hierarchy.h"
+
+/**************** Utils ***************/
+
+static uint8_t *getSetState(Level *level, uint32_t set) {
+  return level->policyState + (size_t)set * level->policyStride;
+}
+
+/* for policies without state shared by the whole level */
+static void ignoreInit(Level *level) {
+  (void)level;
+}
+
+/* for policies without state per set */
+static void ignoreInitSet(Level *level, uint32_t set) {
+  (void)level; (void)set;
+}
+
+/* for policies that do not track hits */
+static void ignoreTouch(Level *level, uint32_t set, uint32_t way) {
+  (void)level; (void)set; (void)way;
+}
+
+/**************** LRU ***************/
+
+/*
+recency list of the ways of a set, most recently used at the head
+
+  | head | tail | prev[ways] | next[ways] |
+*/
+
+static uint32_t lruSetSize(uint32_t ways) { return 2 + 2 * ways; }
+
+static void lruInitSet(Level *level, uint32_t set) {
+  uint8_t *state = getSetState(level, set);
+  uint8_t *prev = state + 2, *next = state + 2 + level->ways;
+
+  state[0] = 0;
+  state[1] = level->ways - 1;
+
+  for (uint32_t way = 0; way < level->ways; way++) {
+    prev[way] = way - 1;
+    next[way] = way + 1;
+  }
+}
+
+static void lruTouch(Level *level, uint32_t set, uint32_t way) {
+  uint8_t *state = getSetState(level, set);
+  uint8_t *prev = state + 2, *next = state + 2 + level->ways;
+
+  if (state[0] == way)
+    return;
+
+  /* unlink, way is not the head so it has a previous way */
+  next[prev[way]] = next[way];
+  if (state[1] == way)
+    state[1] = prev[way];
+  else
+    prev[next[way]] = prev[way];
+
+  /* link as the new head */
+  prev[state[0]] = way;
+  next[way] = state[0];
+  state[0] = way;
+}
+
+static uint32_t lruVictim(Level *level, uint32_t set) {
+  return getSetState(level, set)[1];
+}
+
+/**************** Tree PLRU ***************/
+
+/*
+binary tree over the ways, node n has children 2n and 2n + 1 and the leaves
+are nodes ways .. 2 * ways - 1. A node bit of 0 means the victim is on the
+left, bit n of the set's uint64_t holds node n
+*/
+
+static uint32_t plruSetSize(uint32_t ways) { (void)ways; return sizeof(uint64_t); }
+
+static void plruInitSet(Level *level, uint32_t set) {
+  memset(getSetState(level, set), 0, sizeof(uint64_t));
+}
+
+static void plruTouch(Level *level, uint32_t set, uint32_t way) {
+  uint64_t bits;
+  uint32_t node = way + level->ways;
+
+  memcpy(&bits, getSetState(level, set), sizeof(uint64_t));
+
+  /* every node on the path points away from the touched way */
+  for (; node > 1; node >>= 1) {
+    uint64_t parent = 1ULL << (node >> 1);
+
+    if (node & 1)
+      bits &= ~parent;
+    else
+      bits |= parent;
+  }
+
+  memcpy(getSetState(level, set), &bits, sizeof(uint64_t));
+}
+
+static uint32_t plruVictim(Level *level, uint32_t set) {
+  uint64_t bits;
+  uint32_t node = 1;
+
+  memcpy(&bits, getSetState(level, set), sizeof(uint64_t));
+
+  while (node < level->ways)
+    node = 2 * node + ((bits >> node) & 1);
+
+  return node - level->ways;
+}
+
+/**************** RRIP ***************/
+
+/*
+2 bit re-reference prediction value per way, 0 = near re-reference and
+3 = distant. The set keeps one way mask per value so finding a way at 3, and
+aging the whole set when there is none, are a few mask operations
+*/
+
+#define RRPV_MAX 3
+#define BRRIP_LONG_EVERY 32
+
+static uint32_t rripSetSize(uint32_t ways) { (void)ways; return (RRPV_MAX + 1) * sizeof(uint64_t); }
+
+static void rripSet(Level *level, uint32_t set, uint32_t way, uint32_t rrpv) {
+  uint64_t masks[RRPV_MAX + 1];
+  uint64_t bit = 1ULL << way;
+
+  memcpy(masks, getSetState(level, set), sizeof(masks));
+
+  for (int i = 0; i <= RRPV_MAX; i++)
+    masks[i] &= ~bit;
+  masks[rrpv] |= bit;
+
+  memcpy(getSetState(level, set), masks, sizeof(masks));
+}
+
+static void rripInit(Level *level) {
+  level->policyCounter = 0;
+}
+
+static void rripInitSet(Level *level, uint32_t set) {
+  uint64_t masks[RRPV_MAX + 1] = {0, 0, 0, level->waysMask};
+
+  memcpy(getSetState(level, set), masks, sizeof(masks));
+}
+
+static void rripTouch(Level *level, uint32_t set, uint32_t way) {
+  rripSet(level, set, way, 0);
+}
+
+static void srripInsert(Level *level, uint32_t set, uint32_t way) {
+  rripSet(level, set, way, RRPV_MAX - 1);
+}
+
+static void brripInsert(Level *level, uint32_t set, uint32_t way) {
+  uint32_t rrpv = ++level->policyCounter % BRRIP_LONG_EVERY == 0 ? RRPV_MAX - 1 : RRPV_MAX;
+
+  rripSet(level, set, way, rrpv);
+}
+
+static uint32_t rripVictim(Level *level, uint32_t set) {
+  uint64_t masks[RRPV_MAX + 1];
+
+  memcpy(masks, getSetState(level, set), sizeof(masks));
+
+  if (masks[RRPV_MAX] == 0) {
+    /* age every way by as much as it takes for one to reach RRPV_MAX */
+    int highest = RRPV_MAX - 1;
+    while (masks[highest] == 0)
+      highest--;
+
+    int age = RRPV_MAX - highest;
+    for (int i = RRPV_MAX; i >= 0; i--)
+      masks[i] = i - age >= 0 ? masks[i - age] : 0;
+
+    memcpy(getSetState(level, set), masks, sizeof(masks));
+  }
+
+  return __builtin_ctzll(masks[RRPV_MAX]);
+}
+
+/**************** FIFO ***************/
+
+/* ways are filled in order once the set is full, oldest first */
+
+static uint32_t fifoSetSize(uint32_t ways) { (void)ways; return 1; }
+
+static void fifoInitSet(Level *level, uint32_t set) {
+  *getSetState(level, set) = 0;
+}
+
+static uint32_t fifoVictim(Level *level, uint32_t set) {
+  uint8_t *next = getSetState(level, set);
+  uint32_t way = *next;
+
+  *next = (way + 1) & (level->ways - 1);
+
+  return way;
+}
+
+/**************** Random ***************/
+
+static uint32_t randomSetSize(uint32_t ways) { (void)ways; return 0; }
+
+static void randomInit(Level *level) {
+  /* same sequence on every init so runs are reproducible */
+  level->policyCounter = 0x9E3779B9;
+}
+
+static uint32_t randomVictim(Level *level, uint32_t set) {
+  uint32_t x = level->policyCounter;
+
+  (void)set;
+
+  /* xorshift32 */
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  level->policyCounter = x;
+
+  return x & (level->ways - 1);
+}
+
+/**************** Policies ***************/
+
+static const Policy policies[POLICIES] = {
+  [POLICY_LRU] = {"lru", lruSetSize, ignoreInit, lruInitSet, lruTouch, lruTouch, lruVictim},
+  [POLICY_PLRU] = {"plru", plruSetSize, ignoreInit, plruInitSet, plruTouch, plruTouch, plruVictim},
+  [POLICY_SRRIP] = {"srrip", rripSetSize, rripInit, rripInitSet, rripTouch, srripInsert, rripVictim},
+  [POLICY_BRRIP] = {"brrip", rripSetSize, rripInit, rripInitSet, rripTouch, brripInsert, rripVictim},
+  [POLICY_FIFO] = {"fifo", fifoSetSize, ignoreInit, fifoInitSet, ignoreTouch, ignoreTouch, fifoVictim},
+  [POLICY_RANDOM] = {"random", randomSetSize, randomInit, ignoreInitSet, ignoreTouch, ignoreTouch, randomVictim},
+};
+
+const Policy *getPolicy(uint32_t id) {
+  return &policies[id];
+}
+
+int findPolicy(const char *name) {
+  for (int i = 0; i < POLICIES; i++) {
+    if (strcmp(policies[i].Name, name) == 0)
+      return i;
+  }
+
+  return -1;
+}
@@ -0,0 +1,56 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdint.h>
+
+/*
+Replacement policies
+
+A policy keeps its own compact state for every set of a level and is told
+about hits (touch) and fills (insert). init resets the state shared by the
+whole level, initSet the state of one set, which the level only does the
+first time the set is used after a reset (see Hierarchy.h). It is only asked for a victim when
+every way of the set is valid, invalid ways are always filled first by the
+level itself. All victim selections are constant time:
+
+  lru     true LRU, recency list of ways per set (2 * ways + 2 bytes)
+  plru    tree pseudo LRU, ways - 1 bits per set
+  srrip   static re-reference interval prediction, 2 bit RRPV per way
+          kept as one way mask per RRPV value (4 * 8 bytes per set)
+  brrip   bimodal RRIP, like srrip but inserts at distant re-reference
+          except once every 32 fills
+  fifo    round robin pointer per set (1 byte)
+  random  xorshift per level, no per set state
+
+Policies support up to MAX_WAYS ways, one bit per way in a uint64_t.
+*/
+
+#define MAX_WAYS 64
+
+#define POLICY_LRU 0
+#define POLICY_PLRU 1
+#define POLICY_SRRIP 2
+#define POLICY_BRRIP 3
+#define POLICY_FIFO 4
+#define POLICY_RANDOM 5
+#define POLICIES 6
+
+struct Level;
+
+typedef struct Policy {
+  const char *Name;
+  /* bytes of state needed for one set */
+  uint32_t (*setSize)(uint32_t ways);
+  void (*init)(struct Level *);
+  void (*initSet)(struct Level *, uint32_t);
+  void (*touch)(struct Level *, uint32_t, uint32_t);
+  void (*insert)(struct Level *, uint32_t, uint32_t);
+  uint32_t (*victim)(struct Level *, uint32_t);
+} Policy;
+
+const Policy *getPolicy(uint32_t);
+
+/* returns the POLICY_* id for a name, -1 if there is none */
+int findPolicy(const char *);
+
+#endif
@@ -0,0 +1,174 @@
+#include "Hierarchy.h"
+#include "Prefetch.h"
+
+/**************** Utils ***************/
+
+static uint64_t getBlock(const Level *level, uint64_t address) {
+  return address >> level->offsetBits;
+}
+
+static void prefetchAhead(Level *level, uint64_t block, uint32_t count) {
+  for (uint32_t i = 1; i <= count; i++)
+    prefetchBlock(level, (block + i) << level->offsetBits);
+}
+
+/**************** Next line ***************/
+
+static uint32_t nextStateSize(Level *level) { (void)level; return 0; }
+
+static void nextInit(Level *level) { (void)level; }
+
+static void nextAccess(Level *level, uint64_t address, uint32_t event) {
+  if (event != PREFETCH_ON_HIT)
+    prefetchAhead(level, getBlock(level, address), level->config->PrefetchDegree);
+}
+
+/**************** Stride (RPT) ***************/
+
+#define RPT_ENTRIES 64
+#define RPT_REGION_BITS 12
+#define RPT_CONFIDENT 2
+
+typedef struct StrideEntry {
+  uint64_t key;     /* region + 1, 0 when empty */
+  uint64_t last;
+  int64_t stride;
+  uint32_t confidence;
+} StrideEntry;
+
+/* the last entry follows the whole access stream, for strides wider than a region */
+static uint32_t strideStateSize(Level *level) { (void)level; return (RPT_ENTRIES + 1) * sizeof(StrideEntry); }
+
+static void strideInit(Level *level) {
+  memset(level->prefetchState, 0, (RPT_ENTRIES + 1) * sizeof(StrideEntry));
+}
+
+/* returns the stride to prefetch with, 0 until it was seen twice in a row */
+static int64_t strideUpdate(StrideEntry *entry, uint64_t key, uint64_t address) {
+  if (entry->key != key + 1) {
+    entry->key = key + 1;
+    entry->last = address;
+    entry->stride = 0;
+    entry->confidence = 0;
+    return 0;
+  }
+
+  int64_t stride = (int64_t)(address - entry->last);
+  entry->last = address;
+
+  if (stride == 0)
+    return 0;
+
+  if (stride != entry->stride) {
+    entry->stride = stride;
+    entry->confidence = 0;
+    return 0;
+  }
+
+  if (entry->confidence < RPT_CONFIDENT)
+    entry->confidence++;
+
+  return entry->confidence < RPT_CONFIDENT ? 0 : stride;
+}
+
+static void strideAccess(Level *level, uint64_t address, uint32_t event) {
+  StrideEntry *table = (StrideEntry *)level->prefetchState;
+  uint64_t region = address >> RPT_REGION_BITS;
+  (void)event;
+
+  int64_t stride = strideUpdate(&table[region % RPT_ENTRIES], region, address);
+  int64_t global = strideUpdate(&table[RPT_ENTRIES], 0, address);
+
+  if (stride == 0)
+    stride = global;
+  if (stride == 0)
+    return;
+
+  uint64_t block = getBlock(level, address);
+
+  for (uint32_t i = 1; i <= level->config->PrefetchDegree; i++) {
+    uint64_t target = address + (uint64_t)(stride * i);
+
+    /* strides within a block only need the next block once */
+    if (getBlock(level, target) != block)
+      prefetchBlock(level, target);
+  }
+}
+
+/**************** Streams ***************/
+
+#define STREAMS 8
+
+typedef struct Stream {
+  uint64_t next;    /* block the stream expects next */
+  uint64_t ahead;   /* last block prefetched */
+  uint64_t used;    /* for LRU replacement, 0 when free */
+} Stream;
+
+typedef struct StreamState {
+  Stream stream[STREAMS];
+  uint64_t clock;
+} StreamState;
+
+static uint32_t streamStateSize(Level *level) { (void)level; return sizeof(StreamState); }
+
+static void streamInit(Level *level) {
+  memset(level->prefetchState, 0, sizeof(StreamState));
+}
+
+static void streamAccess(Level *level, uint64_t address, uint32_t event) {
+  StreamState *state = (StreamState *)level->prefetchState;
+  uint64_t block = getBlock(level, address);
+  uint32_t degree = level->config->PrefetchDegree;
+  Stream *oldest = &state->stream[0];
+
+  state->clock++;
+
+  for (uint32_t i = 0; i < STREAMS; i++) {
+    Stream *stream = &state->stream[i];
+
+    if (stream->used != 0 && block >= stream->next && block <= stream->ahead) {
+      stream->next = block + 1;
+      stream->used = state->clock;
+
+      for (; stream->ahead < block + degree; stream->ahead++)
+        prefetchBlock(level, (stream->ahead + 1) << level->offsetBits);
+      return;
+    }
+
+    if (stream->used < oldest->used)
+      oldest = stream;
+  }
+
+  if (event != PREFETCH_ON_MISS)
+    return;
+
+  oldest->next = block + 1;
+  oldest->ahead = block;
+  oldest->used = state->clock;
+
+  for (; oldest->ahead < block + degree; oldest->ahead++)
+    prefetchBlock(level, (oldest->ahead + 1) << level->offsetBits);
+}
+
+/**************** Prefetchers ***************/
+
+static const Prefetcher prefetchers[PREFETCHERS] = {
+  [PREFETCH_NONE] = {"none", NULL, NULL, NULL},
+  [PREFETCH_NEXT] = {"next", nextStateSize, nextInit, nextAccess},
+  [PREFETCH_STRIDE] = {"stride", strideStateSize, strideInit, strideAccess},
+  [PREFETCH_STREAM] = {"stream", streamStateSize, streamInit, streamAccess},
+};
+
+const Prefetcher *getPrefetcher(uint32_t id) {
+  return id == PREFETCH_NONE ? NULL : &prefetchers[id];
+}
+
+int findPrefetcher(const char *name) {
+  for (int i = 0; i < PREFETCHERS; i++) {
+    if (strcmp(prefetchers[i].Name, name) == 0)
+      return i;
+  }
+
+  return -1;
+}
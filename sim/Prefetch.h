@@ -0,0 +1,66 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stdint.h>
+
+/*
+Hardware prefetchers
+
+A prefetcher can be attached to any level (l<n>.prefetch, see Config.h).
+It sees every demand access of the level after it is served and may ask
+for blocks with prefetchBlock(). A prefetched block is filled into the
+level like a miss would, but off the critical path: its latency is not
+added to the clock, the block is only ready that much later. A demand
+access that finds it still in flight waits for the rest (a late prefetch).
+
+  none    no prefetching
+  next    tagged next line, on a miss or on the first hit of a prefetched
+          block fetch the next degree blocks
+  stride  reference prediction table of 64 entries. There are no program
+          counters in the accesses, so entries are indexed by the 4 KiB
+          region of the address, each tracks the last address and stride
+          seen in it and prefetches degree strides ahead once the same
+          stride was seen twice in a row. One more entry follows the
+          whole access stream, for strides wider than a region
+  stream  8 stream trackers (stream buffers that fill into the level), a
+          miss outside every stream starts a new one in place of the least
+          recently used, an access inside a stream keeps it degree blocks
+          ahead
+
+Each level counts (see Stats.h) prefetches issued, useful ones (a demand
+hit on a prefetched block), late ones, useless ones (evicted unused) and
+pollution: demand misses on blocks a prefetch evicted, found through a
+direct mapped filter of the blocks evicted by prefetches.
+*/
+
+#define PREFETCH_NONE 0
+#define PREFETCH_NEXT 1
+#define PREFETCH_STRIDE 2
+#define PREFETCH_STREAM 3
+#define PREFETCHERS 4
+
+/* what the access that triggers the prefetcher did */
+#define PREFETCH_ON_MISS 0
+#define PREFETCH_ON_HIT 1
+#define PREFETCH_ON_PREFETCHED 2 /* first hit on a prefetched block */
+
+struct Level;
+
+typedef struct Prefetcher {
+  const char *Name;
+  /* bytes of state needed for the level */
+  uint32_t (*stateSize)(struct Level *);
+  void (*init)(struct Level *);
+  void (*access)(struct Level *, uint64_t, uint32_t);
+} Prefetcher;
+
+/* NULL for PREFETCH_NONE */
+const Prefetcher *getPrefetcher(uint32_t);
+
+/* returns the PREFETCH_* id for a name, -1 if there is none */
+int findPrefetcher(const char *);
+
+/* fills the block holding address into the level unless it is there already */
+void prefetchBlock(struct Level *, uint64_t);
+
+#endif
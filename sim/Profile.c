@@ -0,0 +1,226 @@
+#include "Profile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_TABLE 256 /* initial pcs */
+
+/**************** Regions ***************/
+
+static int compareRegions(const void *a, const void *b) {
+  const Region *x = a, *y = b;
+
+  return x->Start < y->Start ? -1 : x->Start > y->Start;
+}
+
+int loadRegions(Region **regions, uint32_t *count, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "profile: cannot open %s\n", path);
+    return -1;
+  }
+
+  Region *loaded = NULL;
+  uint32_t loadedCount = 0, capacity = 0;
+  char line[256];
+  int lineNumber = 0, failed = 0;
+
+  while (!failed && fgets(line, sizeof(line), file) != NULL) {
+    char name[REGION_NAME];
+    unsigned long long start, size;
+    char first;
+
+    lineNumber++;
+
+    /* skip blank lines and comments */
+    if (sscanf(line, " %c", &first) != 1 || first == '#')
+      continue;
+
+    if (sscanf(line, " %31s %lli %lli", name, &start, &size) != 3 || size == 0 ||
+        start + size < start) {
+      fprintf(stderr, "profile: %s:%d: bad region\n", path, lineNumber);
+      failed = 1;
+      break;
+    }
+
+    if (loadedCount == capacity) {
+      capacity = capacity ? 2 * capacity : 16;
+      loaded = realloc(loaded, capacity * sizeof(Region));
+      if (loaded == NULL)
+        exit(-1);
+    }
+
+    Region *region = &loaded[loadedCount++];
+    strcpy(region->Name, name);
+    region->Start = start;
+    region->End = start + size;
+  }
+
+  fclose(file);
+
+  if (!failed && loadedCount > 0) {
+    qsort(loaded, loadedCount, sizeof(Region), compareRegions);
+
+    for (uint32_t i = 1; i < loadedCount && !failed; i++) {
+      if (loaded[i].Start < loaded[i - 1].End) {
+        fprintf(stderr, "profile: regions %s and %s overlap\n", loaded[i - 1].Name, loaded[i].Name);
+        failed = 1;
+      }
+    }
+  }
+
+  if (failed) {
+    free(loaded);
+    return -1;
+  }
+
+  *regions = loaded;
+  *count = loadedCount;
+
+  return 0;
+}
+
+/* index of the region holding address, count (other) for none */
+static uint32_t findRegion(const Profile *profile, uint64_t address) {
+  uint32_t low = 0, high = profile->regionCount;
+
+  /* first region starting after address */
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+
+    if (profile->regions[middle].Start <= address)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  if (low > 0 && address < profile->regions[low - 1].End)
+    return low - 1;
+
+  return profile->regionCount;
+}
+
+/**************** PCs ***************/
+
+static ProfileCounters *getPcCounters(Profile *profile, uint64_t pc) {
+  uint32_t index = *addBlock(&profile->pcIndex, pc, profile->pcCount);
+
+  if (index < profile->pcCount)
+    return &profile->pcCounters[index];
+
+  if (profile->pcCount == profile->pcCapacity) {
+    profile->pcCapacity = profile->pcCapacity ? 2 * profile->pcCapacity : PROFILE_TABLE;
+    profile->pcs = realloc(profile->pcs, profile->pcCapacity * sizeof(uint64_t));
+    profile->pcCounters = realloc(profile->pcCounters, profile->pcCapacity * sizeof(ProfileCounters));
+    if (profile->pcs == NULL || profile->pcCounters == NULL)
+      exit(-1);
+  }
+
+  profile->pcs[index] = pc;
+  memset(&profile->pcCounters[index], 0, sizeof(ProfileCounters));
+  profile->pcCount++;
+
+  return &profile->pcCounters[index];
+}
+
+/**************** Profile ***************/
+
+void initProfile(Profile *profile, const Region *regions, uint32_t regionCount) {
+  memset(profile, 0, sizeof(Profile));
+  initBlockMap(&profile->pcIndex, 2 * PROFILE_TABLE);
+
+  profile->regions = regions;
+  profile->regionCount = regionCount;
+  profile->regionCounters = calloc(regionCount + 1, sizeof(ProfileCounters));
+  if (profile->regionCounters == NULL)
+    exit(-1);
+}
+
+void freeProfile(Profile *profile) {
+  freeBlockMap(&profile->pcIndex);
+  free(profile->pcs);
+  free(profile->pcCounters);
+  free(profile->regionCounters);
+  memset(profile, 0, sizeof(Profile));
+}
+
+static void addCounters(ProfileCounters *to, const ProfileCounters *from) {
+  to->Accesses += from->Accesses;
+  to->Misses += from->Misses;
+  to->Dram += from->Dram;
+  to->Time += from->Time;
+}
+
+void profileAccess(Profile *profile, uint64_t pc, uint64_t address, const ProfileCounters *access) {
+  addCounters(getPcCounters(profile, pc), access);
+  addCounters(&profile->regionCounters[findRegion(profile, address)], access);
+}
+
+void addProfile(Profile *to, const Profile *from) {
+  for (uint32_t i = 0; i < from->pcCount; i++)
+    addCounters(getPcCounters(to, from->pcs[i]), &from->pcCounters[i]);
+
+  for (uint32_t i = 0; i <= to->regionCount; i++)
+    addCounters(&to->regionCounters[i], &from->regionCounters[i]);
+}
+
+/**************** Report ***************/
+
+typedef struct ProfileRow {
+  char Name[REGION_NAME];
+  ProfileCounters Counters;
+} ProfileRow;
+
+/* most misses first, then most time, then by name so the order is stable */
+static int compareRows(const void *a, const void *b) {
+  const ProfileRow *x = a, *y = b;
+
+  if (x->Counters.Misses != y->Counters.Misses)
+    return x->Counters.Misses > y->Counters.Misses ? -1 : 1;
+  if (x->Counters.Time != y->Counters.Time)
+    return x->Counters.Time > y->Counters.Time ? -1 : 1;
+
+  return strcmp(x->Name, y->Name);
+}
+
+static void writeRows(const char *kind, ProfileRow *rows, uint64_t count, FILE *file) {
+  qsort(rows, count, sizeof(ProfileRow), compareRows);
+
+  for (uint64_t i = 0; i < count; i++) {
+    const ProfileCounters *counters = &rows[i].Counters;
+
+    fprintf(file, "%s,%s,%llu,%llu,%llu,%llu\n", kind, rows[i].Name,
+            (unsigned long long)counters->Accesses, (unsigned long long)counters->Misses,
+            (unsigned long long)counters->Dram, (unsigned long long)counters->Time);
+  }
+}
+
+void writeProfile(const Profile *profile, FILE *file) {
+  uint64_t count = profile->pcCount > profile->regionCount + 1 ? profile->pcCount
+                                                               : profile->regionCount + 1;
+  ProfileRow *rows = malloc(count * sizeof(ProfileRow));
+  if (rows == NULL)
+    exit(-1);
+
+  fprintf(file, "kind,name,accesses,misses,dram,time\n");
+
+  for (uint32_t i = 0; i < profile->pcCount; i++) {
+    snprintf(rows[i].Name, REGION_NAME, "0x%llx", (unsigned long long)profile->pcs[i]);
+    rows[i].Counters = profile->pcCounters[i];
+  }
+
+  writeRows("pc", rows, profile->pcCount, file);
+
+  count = 0;
+  for (uint32_t i = 0; i <= profile->regionCount; i++) {
+    if (profile->regionCounters[i].Accesses == 0)
+      continue;
+
+    strcpy(rows[count].Name, i < profile->regionCount ? profile->regions[i].Name : "other");
+    rows[count++].Counters = profile->regionCounters[i];
+  }
+
+  writeRows("region", rows, count, file);
+
+  free(rows);
+}
@@ -0,0 +1,76 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "BlockMap.h"
+
+/*
+Miss attribution
+
+A Profile charges every access to the program counter that issued it (from
+the trace, see Trace.h, 0 when the trace has none) and to the named
+address region it falls in, counting for each
+
+  accesses
+  misses    L1 misses
+  dram      blocks read from DRAM on its behalf
+  time      cycles beyond an L1 hit, what its misses added to the run
+
+PCs are found through a BlockMap (see BlockMap.h). Regions come from a file of lines
+
+  <name> <start> <size>
+
+with C notation numbers and '#' comments. They are sorted by start and
+found by binary search, so they must not overlap. Accesses outside every
+region are charged to "other".
+
+The region table is read only and can be shared by the Profiles of several
+shards, addProfile() then merges their counters. writeProfile() ranks the
+PCs and then the regions by misses, then time, as csv:
+
+  kind,name,accesses,misses,dram,time
+*/
+
+#define REGION_NAME 32
+
+typedef struct ProfileCounters {
+  uint64_t Accesses;
+  uint64_t Misses;
+  uint64_t Dram;
+  uint64_t Time;
+} ProfileCounters;
+
+typedef struct Region {
+  char Name[REGION_NAME];
+  uint64_t Start;
+  uint64_t End;         /* exclusive */
+} Region;
+
+typedef struct Profile {
+  /* pc -> index of its counters, in the order pcs were first seen */
+  BlockMap pcIndex;
+  uint64_t *pcs;
+  ProfileCounters *pcCounters;
+  uint32_t pcCount;
+  uint32_t pcCapacity;
+  /* regions, the extra last counters are other */
+  const Region *regions;
+  uint32_t regionCount;
+  ProfileCounters *regionCounters;
+} Profile;
+
+/* returns the sorted regions of a file in *regions, -1 if it is bad */
+int loadRegions(Region **regions, uint32_t *count, const char *path);
+
+void initProfile(Profile *, const Region *, uint32_t);
+void freeProfile(Profile *);
+
+void profileAccess(Profile *, uint64_t pc, uint64_t address, const ProfileCounters *);
+
+/* adds the counters of one profile to another with the same regions */
+void addProfile(Profile *, const Profile *);
+
+void writeProfile(const Profile *, FILE *);
+
+#endif
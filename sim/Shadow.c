@@ -0,0 +1,92 @@
+#include "Shadow.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SHADOW_TABLE 1024 /* initial slots */
+
+/**************** LRU list ***************/
+
+static void unlinkLine(ShadowCache *shadow, uint32_t i) {
+  if (shadow->prev[i] != SHADOW_NONE)
+    shadow->next[shadow->prev[i]] = shadow->next[i];
+  else
+    shadow->head = shadow->next[i];
+
+  if (shadow->next[i] != SHADOW_NONE)
+    shadow->prev[shadow->next[i]] = shadow->prev[i];
+  else
+    shadow->tail = shadow->prev[i];
+}
+
+static void pushLine(ShadowCache *shadow, uint32_t i) {
+  shadow->prev[i] = SHADOW_NONE;
+  shadow->next[i] = shadow->head;
+
+  if (shadow->head != SHADOW_NONE)
+    shadow->prev[shadow->head] = i;
+  else
+    shadow->tail = i;
+
+  shadow->head = i;
+}
+
+/**************** Shadow ***************/
+
+void initShadow(ShadowCache *shadow, uint32_t lines) {
+  memset(shadow, 0, sizeof(ShadowCache));
+  shadow->lines = lines;
+
+  shadow->block = malloc(lines * sizeof(uint64_t));
+  shadow->prev = malloc(lines * sizeof(uint32_t));
+  shadow->next = malloc(lines * sizeof(uint32_t));
+  if (shadow->block == NULL || shadow->prev == NULL || shadow->next == NULL)
+    exit(-1);
+
+  initBlockMap(&shadow->seen, SHADOW_TABLE);
+  resetShadow(shadow);
+}
+
+void resetShadow(ShadowCache *shadow) {
+  clearBlockMap(&shadow->seen);
+  shadow->used = 0;
+  shadow->head = SHADOW_NONE;
+  shadow->tail = SHADOW_NONE;
+}
+
+void freeShadow(ShadowCache *shadow) {
+  free(shadow->block);
+  free(shadow->prev);
+  free(shadow->next);
+  freeBlockMap(&shadow->seen);
+  memset(shadow, 0, sizeof(ShadowCache));
+}
+
+uint32_t accessShadow(ShadowCache *shadow, uint64_t block) {
+  uint32_t *seen = findBlock(&shadow->seen, block);
+  uint32_t i = seen != NULL ? *seen : SHADOW_NONE;
+
+  /* HIT, moves to the MRU end */
+  if (i != SHADOW_NONE) {
+    unlinkLine(shadow, i);
+    pushLine(shadow, i);
+    return MISS_CONFLICT;
+  }
+
+  uint32_t kind = seen == NULL ? MISS_COMPULSORY : MISS_CAPACITY;
+
+  /* MISS, takes a free line or the LRU one */
+  if (shadow->used < shadow->lines)
+    i = shadow->used++;
+  else {
+    i = shadow->tail;
+    unlinkLine(shadow, i);
+    *findBlock(&shadow->seen, shadow->block[i]) = SHADOW_NONE;
+  }
+
+  shadow->block[i] = block;
+  *addBlock(&shadow->seen, block, i) = i;
+  pushLine(shadow, i);
+
+  return kind;
+}
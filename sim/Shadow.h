@@ -0,0 +1,55 @@
+#ifndef SHADOW_H
+#define SHADOW_H
+
+#include <stdint.h>
+#include "BlockMap.h"
+
+/*
+3C miss classification
+
+With classify = 1 every level keeps a shadow cache next to it, a fully
+associative LRU cache of the same number of lines, and the set of blocks
+it has ever seen. Every access the level counts as a hit or a miss (write
+backs from the level above included) also goes to the shadow, and a miss of
+the level is then
+
+  compulsory  the block was never accessed before (since the last reset)
+  conflict    the shadow hit, more ways would have kept the block
+  capacity    the shadow missed too, only a bigger cache would have
+
+Both live in one block -> line map (see BlockMap.h): a seen block that is
+not in the shadow maps to SHADOW_NONE. The LRU order is a doubly linked
+list of lines, so an access is O(1). A reset is constant time too, the map
+starts a new epoch and the lines are refilled from the first. Memory grows
+with the distinct blocks seen, 32 to 64 bytes each, which is why
+classification is off by default.
+
+Prefetch fills and coherence invalidations do not touch the shadow, so
+misses they cause or avoid are classified as if they had not happened.
+*/
+
+#define MISS_COMPULSORY 0
+#define MISS_CAPACITY 1
+#define MISS_CONFLICT 2
+
+#define SHADOW_NONE UINT32_MAX
+
+typedef struct ShadowCache {
+  uint32_t lines;
+  uint32_t used;       /* lines filled so far */
+  uint64_t *block;     /* per line */
+  uint32_t *prev;      /* per line, towards the MRU end */
+  uint32_t *next;      /* per line, towards the LRU end */
+  uint32_t head;       /* MRU line */
+  uint32_t tail;       /* LRU line */
+  BlockMap seen;       /* block -> line, SHADOW_NONE when not held */
+} ShadowCache;
+
+void initShadow(ShadowCache *, uint32_t lines);
+void resetShadow(ShadowCache *);
+void freeShadow(ShadowCache *);
+
+/* touches the block, returns the MISS_* class a miss on it has */
+uint32_t accessShadow(ShadowCache *, uint64_t block);
+
+#endif
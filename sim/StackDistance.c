@@ -0,0 +1,388 @@
+#include "StackDistance.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NIL 0 /* node 0 is the empty tree, blocks start at node 1 */
+#define TIME_BITS 40
+
+/**************** Utils ***************/
+
+static uint32_t nextRandom(StackDistance *sd) {
+  uint32_t x = sd->seed;
+
+  /* xorshift32 */
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sd->seed = x;
+
+  return x;
+}
+
+/* spatial hash deciding whether a block is sampled, independent of the BlockMap hash */
+static uint32_t sampleHash(uint64_t block) {
+  block ^= block >> 33;
+  block *= 0xFF51AFD7ED558CCDULL;
+  block ^= block >> 33;
+  block *= 0xC4CEB9FE1A85EC53ULL;
+  block ^= block >> 33;
+
+  return (uint32_t)block & (SAMPLE_MODULUS - 1);
+}
+
+static uint32_t getBucket(uint64_t distance) {
+  return distance == 0 ? 0 : 64 - __builtin_clzll(distance);
+}
+
+/* key of node i in tree k, ordered by set first and by last access second */
+static inline uint64_t getKey(const StackDistance *sd, uint32_t k, uint32_t i) {
+  uint64_t set = sd->block[i] & ((1ULL << k) - 1);
+
+  return (set << TIME_BITS) | sd->last[i];
+}
+
+/**************** Storage ***************/
+
+static void *growArray(void *array, size_t count, size_t size) {
+  void *grown = realloc(array, count * size);
+  if (grown == NULL)
+    exit(-1);
+
+  return grown;
+}
+
+/* returns a free node, doubling the node arrays when there is none */
+static uint32_t allocNode(StackDistance *sd) {
+  if (sd->freeCount > 0)
+    return sd->freeNodes[--sd->freeCount];
+
+  if (sd->nodes + 1 >= sd->capacity) {
+    sd->capacity *= 2;
+
+    sd->block = growArray(sd->block, sd->capacity, sizeof(uint64_t));
+    sd->last = growArray(sd->last, sd->capacity, sizeof(uint64_t));
+    sd->priority = growArray(sd->priority, sd->capacity, sizeof(uint32_t));
+    sd->heap = growArray(sd->heap, sd->capacity, sizeof(uint32_t));
+    sd->freeNodes = growArray(sd->freeNodes, sd->capacity, sizeof(uint32_t));
+
+    for (uint32_t k = 0; k < sd->trees; k++) {
+      StackTree *tree = &sd->tree[k];
+
+      tree->left = growArray(tree->left, sd->capacity, sizeof(uint32_t));
+      tree->right = growArray(tree->right, sd->capacity, sizeof(uint32_t));
+      tree->size = growArray(tree->size, sd->capacity, sizeof(uint32_t));
+    }
+  }
+
+  return ++sd->nodes;
+}
+
+/**************** Sample heap ***************/
+
+/* max heap of the tracked nodes by sample hash, only used with maxBlocks */
+
+static void pushSample(StackDistance *sd, uint32_t i) {
+  uint32_t pos = sd->blocks - 1, hash = sampleHash(sd->block[i]);
+
+  while (pos > 0 && sampleHash(sd->block[sd->heap[(pos - 1) / 2]]) < hash) {
+    sd->heap[pos] = sd->heap[(pos - 1) / 2];
+    pos = (pos - 1) / 2;
+  }
+
+  sd->heap[pos] = i;
+}
+
+/* removes the top, the heap holds blocks entries before the call */
+static uint32_t popSample(StackDistance *sd) {
+  uint32_t top = sd->heap[0], last = sd->heap[sd->blocks - 1];
+  uint32_t count = sd->blocks - 1, pos = 0, hash = sampleHash(sd->block[last]);
+
+  while (2 * pos + 1 < count) {
+    uint32_t child = 2 * pos + 1;
+
+    if (child + 1 < count &&
+        sampleHash(sd->block[sd->heap[child + 1]]) > sampleHash(sd->block[sd->heap[child]]))
+      child++;
+
+    if (sampleHash(sd->block[sd->heap[child]]) <= hash)
+      break;
+
+    sd->heap[pos] = sd->heap[child];
+    pos = child;
+  }
+
+  if (count > 0)
+    sd->heap[pos] = last;
+
+  return top;
+}
+
+/**************** Treap ***************/
+
+static void update(StackTree *tree, uint32_t node) {
+  tree->size[node] = 1 + tree->size[tree->left[node]] + tree->size[tree->right[node]];
+}
+
+/* number of keys smaller than key */
+static uint32_t countLess(const StackDistance *sd, uint32_t k, uint64_t key) {
+  const StackTree *tree = &sd->tree[k];
+  uint32_t node = tree->root, count = 0;
+
+  while (node != NIL) {
+    if (getKey(sd, k, node) < key) {
+      count += tree->size[tree->left[node]] + 1;
+      node = tree->right[node];
+    } else {
+      node = tree->left[node];
+    }
+  }
+
+  return count;
+}
+
+/* splits a subtree into keys smaller than key and the rest */
+static void split(const StackDistance *sd, uint32_t k, uint32_t node, uint64_t key,
+                  uint32_t *less, uint32_t *rest) {
+  StackTree *tree = &sd->tree[k];
+
+  if (node == NIL) {
+    *less = *rest = NIL;
+  } else if (getKey(sd, k, node) < key) {
+    split(sd, k, tree->right[node], key, &tree->right[node], rest);
+    *less = node;
+    update(tree, node);
+  } else {
+    split(sd, k, tree->left[node], key, less, &tree->left[node]);
+    *rest = node;
+    update(tree, node);
+  }
+}
+
+/* every key of a is smaller than every key of b */
+static uint32_t merge(const StackDistance *sd, uint32_t k, uint32_t a, uint32_t b) {
+  StackTree *tree = &sd->tree[k];
+
+  if (a == NIL)
+    return b;
+  if (b == NIL)
+    return a;
+
+  if (sd->priority[a] > sd->priority[b]) {
+    tree->right[a] = merge(sd, k, tree->right[a], b);
+    update(tree, a);
+    return a;
+  }
+
+  tree->left[b] = merge(sd, k, a, tree->left[b]);
+  update(tree, b);
+  return b;
+}
+
+static uint32_t insert(const StackDistance *sd, uint32_t k, uint32_t node, uint32_t i) {
+  StackTree *tree = &sd->tree[k];
+
+  if (node == NIL || sd->priority[i] > sd->priority[node]) {
+    split(sd, k, node, getKey(sd, k, i), &tree->left[i], &tree->right[i]);
+    update(tree, i);
+    return i;
+  }
+
+  if (getKey(sd, k, i) < getKey(sd, k, node))
+    tree->left[node] = insert(sd, k, tree->left[node], i);
+  else
+    tree->right[node] = insert(sd, k, tree->right[node], i);
+
+  update(tree, node);
+  return node;
+}
+
+/* removes node i, its key must not have changed since it was inserted */
+static uint32_t erase(const StackDistance *sd, uint32_t k, uint32_t node, uint32_t i, uint64_t key) {
+  StackTree *tree = &sd->tree[k];
+
+  if (node == i)
+    return merge(sd, k, tree->left[i], tree->right[i]);
+
+  if (key < getKey(sd, k, node))
+    tree->left[node] = erase(sd, k, tree->left[node], i, key);
+  else
+    tree->right[node] = erase(sd, k, tree->right[node], i, key);
+
+  update(tree, node);
+  return node;
+}
+
+/* stops tracking the sampled block with the largest hash and lowers the threshold to it */
+static void dropSample(StackDistance *sd) {
+  uint32_t i = popSample(sd);
+
+  sd->threshold = sampleHash(sd->block[i]);
+
+  for (uint32_t k = 0; k < sd->trees; k++)
+    sd->tree[k].root = erase(sd, k, sd->tree[k].root, i, getKey(sd, k, i));
+
+  removeBlock(&sd->nodeOf, sd->block[i]);
+
+  sd->blocks--;
+  sd->freeNodes[sd->freeCount++] = i;
+}
+
+/**************** Stack Distance ***************/
+
+int initStackDistance(StackDistance *sd, uint32_t offsetBits, uint32_t maxSets) {
+  memset(sd, 0, sizeof(StackDistance));
+
+  if (maxSets == 0 || (maxSets & (maxSets - 1)) != 0 || maxSets > STACK_MAX_SETS) {
+    fprintf(stderr, "stack distance: set count must be a power of two up to %d\n", STACK_MAX_SETS);
+    return -1;
+  }
+
+  sd->offsetBits = offsetBits;
+  sd->trees = __builtin_ctz(maxSets) + 1;
+  sd->tree = calloc(sd->trees, sizeof(StackTree));
+  if (sd->tree == NULL)
+    exit(-1);
+
+  sd->capacity = 1;
+  sd->rateThreshold = SAMPLE_MODULUS;
+
+  /* allocates the arrays, node 0 itself is never handed out */
+  allocNode(sd);
+  initBlockMap(&sd->nodeOf, 1024);
+
+  resetStackDistance(sd);
+
+  return 0;
+}
+
+int setStackSampling(StackDistance *sd, double rate, uint32_t maxBlocks) {
+  if (!(rate > 0 && rate <= 1)) {
+    fprintf(stderr, "stack distance: sampling rate must be in (0, 1]\n");
+    return -1;
+  }
+
+  sd->rateThreshold = (uint32_t)(rate * SAMPLE_MODULUS);
+  if (sd->rateThreshold == 0)
+    sd->rateThreshold = 1;
+  sd->maxBlocks = maxBlocks;
+
+  resetStackDistance(sd);
+
+  return 0;
+}
+
+void freeStackDistance(StackDistance *sd) {
+  for (uint32_t k = 0; k < sd->trees; k++) {
+    free(sd->tree[k].left);
+    free(sd->tree[k].right);
+    free(sd->tree[k].size);
+  }
+
+  free(sd->tree);
+  free(sd->block);
+  free(sd->last);
+  free(sd->priority);
+  free(sd->heap);
+  free(sd->freeNodes);
+  freeBlockMap(&sd->nodeOf);
+
+  memset(sd, 0, sizeof(StackDistance));
+}
+
+void resetStackDistance(StackDistance *sd) {
+  sd->blocks = 0;
+  sd->nodes = 0;
+  sd->freeCount = 0;
+  sd->time = 0;
+  sd->seed = 0x9E3779B9;
+  sd->threshold = sd->rateThreshold;
+
+  clearBlockMap(&sd->nodeOf);
+
+  for (uint32_t k = 0; k < sd->trees; k++) {
+    sd->tree[k].root = NIL;
+    sd->tree[k].size[NIL] = 0;
+  }
+}
+
+void accessStackDistance(StackDistance *sd, uint64_t address) {
+  uint64_t block = address >> sd->offsetBits;
+
+  sd->accesses++;
+
+  /* spatial sampling, every access of a block is either seen or skipped */
+  if (sampleHash(block) >= sd->threshold)
+    return;
+
+  double scale = (double)SAMPLE_MODULUS / sd->threshold;
+  sd->sampled += scale;
+  uint32_t *node = findBlock(&sd->nodeOf, block);
+  uint32_t i = node != NULL ? *node : NIL;
+  int isNew = i == NIL;
+
+  if (isNew) {
+    /* first touch, a miss in every cache */
+    sd->coldMisses += scale;
+
+    i = allocNode(sd);
+    sd->block[i] = block;
+    sd->priority[i] = nextRandom(sd);
+    addBlock(&sd->nodeOf, block, i);
+    sd->blocks++;
+  } else {
+    for (uint32_t k = 0; k < sd->trees; k++) {
+      StackTree *tree = &sd->tree[k];
+      uint64_t key = getKey(sd, k, i);
+
+      /* blocks of the same set touched after this one, they all sort after it */
+      uint64_t setEnd = (key | ((1ULL << TIME_BITS) - 1)) + 1;
+      uint64_t distance = countLess(sd, k, setEnd) - countLess(sd, k, key) - 1;
+
+      /* a sampled distance stands for 1 / rate real ones */
+      tree->histogram[getBucket((uint64_t)(distance * scale))] += scale;
+      tree->root = erase(sd, k, tree->root, i, key);
+    }
+  }
+
+  sd->last[i] = ++sd->time;
+
+  for (uint32_t k = 0; k < sd->trees; k++) {
+    StackTree *tree = &sd->tree[k];
+
+    tree->left[i] = tree->right[i] = NIL;
+    tree->root = insert(sd, k, tree->root, i);
+  }
+
+  if (sd->maxBlocks == 0 || !isNew)
+    return;
+
+  /* fixed size, a new block pushes out the largest hashes */
+  pushSample(sd, i);
+
+  while (sd->blocks > sd->maxBlocks)
+    dropSample(sd);
+
+  /* blocks sharing the hash the threshold dropped to are not sampled anymore */
+  while (sd->blocks > 0 && sampleHash(sd->block[sd->heap[0]]) >= sd->threshold)
+    dropSample(sd);
+}
+
+double getStackMissRatio(const StackDistance *sd, uint32_t sets, uint32_t ways) {
+  const StackTree *tree = &sd->tree[__builtin_ctz(sets)];
+  double misses = sd->coldMisses;
+
+  if (sd->sampled == 0)
+    return 0;
+
+  /* a hit needs a distance below ways, i.e. a bucket up to log2(ways) */
+  for (uint32_t b = __builtin_ctz(ways) + 1; b < STACK_BUCKETS; b++)
+    misses += tree->histogram[b];
+
+  /*
+  over the weighted accesses seen, not all of them: a sample holding fewer
+  blocks than the rate implies would otherwise read as fewer misses
+  */
+  return misses / sd->sampled;
+}
@@ -0,0 +1,103 @@
+#ifndef STACKDISTANCE_H
+#define STACKDISTANCE_H
+
+#include <stdint.h>
+#include "BlockMap.h"
+
+/*
+Mattson stack distance analysis
+
+One pass over the accesses gives the LRU miss count of every cache of
+power of two geometry at once: a cache with S sets and W ways hits an
+access iff fewer than W other blocks of the same set were touched since the
+previous access to its block (its stack distance within the set).
+
+Blocks are split like getBlockOffset/getLineIndex do, set = block & (S - 1),
+and distances are tracked for every set count S = 1, 2, 4 .. maxSets
+(S = 1 is the fully associative cache). For each S an order statistic treap
+holds one node per block keyed by (set, time of last access), so a
+distance is the number of keys between the block's previous key and the end
+of its set, O(log n) per access and set count.
+
+All treaps share the per block arrays (block, last access, priority), only
+the child links and subtree sizes are kept per set count. Distances are
+counted in power of two buckets since every capacity is a power of two.
+
+Sampling (SHARDS)
+
+Exact analysis needs a node per distinct block. setStackSampling() instead
+only tracks blocks whose spatial hash falls below a threshold, rate
+R = threshold / 2^24, so either every access to a block is seen or none
+is. A sampled distance d stands for d / R real ones and every sampled
+access weighs 1 / R, miss ratios are weighted misses over weighted
+sampled accesses.
+
+  fixed rate   the threshold never moves, memory ~ R * distinct blocks
+  fixed size   at most maxBlocks blocks are tracked, when one more comes
+               in the block with the largest hash is dropped and the
+               threshold lowered to its hash, so memory stays constant and
+               R adapts to the footprint. The error shrinks with maxBlocks,
+               a few thousand blocks give miss ratios within about 0.01.
+
+Caches of fewer than about 1 / R blocks are not resolved by either mode,
+their sampled distances are mostly 0.
+*/
+
+#define STACK_BUCKETS 41 /* bucket(d) = bits of d, distances below 2^40 */
+#define STACK_MAX_SETS (1 << 23) /* set << 40 | time must fit in 64 bits */
+#define SAMPLE_BITS 24
+#define SAMPLE_MODULUS (1 << SAMPLE_BITS)
+
+typedef struct StackTree {
+  uint32_t root;
+  uint32_t *left;
+  uint32_t *right;
+  uint32_t *size;
+  double histogram[STACK_BUCKETS]; /* weighted, see sampling */
+} StackTree;
+
+typedef struct StackDistance {
+  uint32_t offsetBits;
+  uint32_t trees;        /* log2(maxSets) + 1 */
+  StackTree *tree;       /* tree[k] tracks 2^k sets */
+
+  /* blocks, node i of every tree is block[i] */
+  uint32_t blocks;      /* tracked right now */
+  uint32_t nodes;       /* nodes 1 .. nodes are in use or free */
+  uint32_t capacity;
+  uint64_t *block;
+  uint64_t *last;
+  uint32_t *priority;
+
+  BlockMap nodeOf;      /* block -> node */
+
+  /* sampling, threshold = SAMPLE_MODULUS tracks every block */
+  uint32_t threshold;
+  uint32_t rateThreshold; /* threshold after a reset */
+  uint32_t maxBlocks;   /* 0 for a fixed rate */
+  uint32_t *heap;       /* tracked nodes, largest hash first */
+  uint32_t *freeNodes;
+  uint32_t freeCount;
+
+  uint64_t time;
+  uint64_t accesses;
+  double coldMisses;    /* weighted */
+  double sampled;       /* weighted accesses seen */
+  uint32_t seed;
+} StackDistance;
+
+int initStackDistance(StackDistance *, uint32_t, uint32_t);
+void freeStackDistance(StackDistance *);
+
+/* sampling rate in (0, 1] and block limit, 0 for a fixed rate */
+int setStackSampling(StackDistance *, double, uint32_t);
+
+/* forgets every block, like initCache() does for a cache */
+void resetStackDistance(StackDistance *);
+
+void accessStackDistance(StackDistance *, uint64_t);
+
+/* LRU miss ratio of a cache with sets * ways lines, both powers of two */
+double getStackMissRatio(const StackDistance *, uint32_t, uint32_t);
+
+#endif
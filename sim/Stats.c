@@ -0,0 +1,235 @@
+#include "Stats.h"
+
+#include <string.h>
+#include "Cache.h"
+
+void resetStats(Stats *stats) {
+  uint32_t levels = stats->levels, cores = stats->cores, victimEntries = stats->victimEntries;
+
+  memset(stats, 0, sizeof(Stats));
+  stats->levels = levels;
+  stats->cores = cores;
+  stats->victimEntries = victimEntries;
+}
+
+void addStats(Stats *to, const Stats *from) {
+  if (from->levels > to->levels)
+    to->levels = from->levels;
+  if (from->cores > to->cores)
+    to->cores = from->cores;
+  if (from->victimEntries > to->victimEntries)
+    to->victimEntries = from->victimEntries;
+
+  for (uint32_t i = 0; i < MAX_LEVELS; i++) {
+    LevelStats *level = &to->level[i];
+    const LevelStats *other = &from->level[i];
+
+    for (int mode = 0; mode < 2; mode++) {
+      level->Hits[mode] += other->Hits[mode];
+      level->Misses[mode] += other->Misses[mode];
+    }
+
+    level->Fills += other->Fills;
+    level->Evictions += other->Evictions;
+    level->Writebacks += other->Writebacks;
+    level->Forwards += other->Forwards;
+    level->BufferStalls += other->BufferStalls;
+    level->Prefetches += other->Prefetches;
+    level->PrefetchUseful += other->PrefetchUseful;
+    level->PrefetchLate += other->PrefetchLate;
+    level->PrefetchUseless += other->PrefetchUseless;
+    level->PrefetchPollution += other->PrefetchPollution;
+    level->Merged += other->Merged;
+    level->MshrStalls += other->MshrStalls;
+    level->BackInvalidations += other->BackInvalidations;
+    level->Compulsory += other->Compulsory;
+    level->Capacity += other->Capacity;
+    level->Conflict += other->Conflict;
+  }
+
+  to->dram.Reads += from->dram.Reads;
+  to->dram.Writes += from->dram.Writes;
+  to->dram.BytesRead += from->dram.BytesRead;
+  to->dram.BytesWritten += from->dram.BytesWritten;
+
+  to->coherence.Invalidations += from->coherence.Invalidations;
+  to->coherence.Upgrades += from->coherence.Upgrades;
+  to->coherence.Interventions += from->coherence.Interventions;
+  to->coherence.CoherenceMisses += from->coherence.CoherenceMisses;
+  to->coherence.FalseSharing += from->coherence.FalseSharing;
+
+  to->victim.Hits += from->victim.Hits;
+  to->victim.Misses += from->victim.Misses;
+  to->victim.Writebacks += from->victim.Writebacks;
+
+  for (uint32_t i = 0; i <= MAX_LEVELS; i++) {
+    for (int mode = 0; mode < 2; mode++) {
+      LatencyHistogram *histogram = &to->latency[i][mode];
+      const LatencyHistogram *other = &from->latency[i][mode];
+
+      histogram->Count += other->Count;
+      histogram->Sum += other->Sum;
+      if (other->Max > histogram->Max)
+        histogram->Max = other->Max;
+
+      for (uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+        histogram->Buckets[bucket] += other->Buckets[bucket];
+    }
+  }
+}
+
+/**************** Latency ***************/
+
+uint64_t getBucketLatency(uint32_t bucket) {
+  if (bucket < 2u << LATENCY_SUB_BITS)
+    return bucket;
+
+  /* bucket = shift << SUB_BITS + mantissa, mantissa in [2^SUB_BITS, 2^(SUB_BITS + 1)) */
+  uint32_t shift = (bucket >> LATENCY_SUB_BITS) - 1;
+  uint64_t mantissa = (bucket & ((1u << LATENCY_SUB_BITS) - 1)) | (1u << LATENCY_SUB_BITS);
+
+  /* wraps to UINT64_MAX for the very last bucket */
+  return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t getLatencyPercentile(const LatencyHistogram *histogram, double fraction) {
+  uint64_t rank = (uint64_t)(fraction * histogram->Count + 0.5);
+  uint64_t seen = 0;
+
+  if (rank == 0)
+    rank = 1;
+
+  for (uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+    seen += histogram->Buckets[bucket];
+
+    /* the top of the last bucket is no more than the largest latency seen */
+    if (seen >= rank)
+      return getBucketLatency(bucket) < histogram->Max ? getBucketLatency(bucket) : histogram->Max;
+  }
+
+  return 0;
+}
+
+/**************** Output ***************/
+
+void writeStatsJSON(const Stats *stats, FILE *file) {
+  fprintf(file, "{\n  \"levels\": [\n");
+
+  for (uint32_t i = 0; i < stats->levels; i++) {
+    const LevelStats *level = &stats->level[i];
+
+    fprintf(file, "    {\"level\": \"l%u\", \"read_hits\": %llu, \"read_misses\": %llu, "
+                  "\"write_hits\": %llu, \"write_misses\": %llu, \"fills\": %llu, "
+                  "\"evictions\": %llu, \"writebacks\": %llu, \"forwards\": %llu, "
+                  "\"buffer_stalls\": %llu, \"prefetches\": %llu, \"prefetch_useful\": %llu, "
+                  "\"prefetch_late\": %llu, \"prefetch_useless\": %llu, \"pollution\": %llu, "
+                  "\"merged\": %llu, \"mshr_stalls\": %llu, \"back_invalidations\": %llu, "
+                  "\"compulsory\": %llu, \"capacity\": %llu, \"conflict\": %llu}%s\n",
+            i + 1, (unsigned long long)level->Hits[MODE_READ],
+            (unsigned long long)level->Misses[MODE_READ],
+            (unsigned long long)level->Hits[MODE_WRITE],
+            (unsigned long long)level->Misses[MODE_WRITE], (unsigned long long)level->Fills,
+            (unsigned long long)level->Evictions, (unsigned long long)level->Writebacks,
+            (unsigned long long)level->Forwards, (unsigned long long)level->BufferStalls,
+            (unsigned long long)level->Prefetches, (unsigned long long)level->PrefetchUseful,
+            (unsigned long long)level->PrefetchLate, (unsigned long long)level->PrefetchUseless,
+            (unsigned long long)level->PrefetchPollution, (unsigned long long)level->Merged,
+            (unsigned long long)level->MshrStalls, (unsigned long long)level->BackInvalidations,
+            (unsigned long long)level->Compulsory, (unsigned long long)level->Capacity,
+            (unsigned long long)level->Conflict, i + 1 < stats->levels ? "," : "");
+  }
+
+  fprintf(file, "  ],\n  \"dram\": {\"reads\": %llu, \"writes\": %llu, "
+                "\"bytes_read\": %llu, \"bytes_written\": %llu}",
+          (unsigned long long)stats->dram.Reads, (unsigned long long)stats->dram.Writes,
+          (unsigned long long)stats->dram.BytesRead, (unsigned long long)stats->dram.BytesWritten);
+
+  if (stats->cores > 1) {
+    const CoherenceStats *coherence = &stats->coherence;
+
+    fprintf(file, ",\n  \"coherence\": {\"cores\": %u, \"invalidations\": %llu, \"upgrades\": %llu, "
+                  "\"interventions\": %llu, \"coherence_misses\": %llu, \"false_sharing\": %llu}",
+            stats->cores, (unsigned long long)coherence->Invalidations,
+            (unsigned long long)coherence->Upgrades, (unsigned long long)coherence->Interventions,
+            (unsigned long long)coherence->CoherenceMisses,
+            (unsigned long long)coherence->FalseSharing);
+  }
+
+  if (stats->victimEntries > 0) {
+    fprintf(file, ",\n  \"victim\": {\"entries\": %u, \"hits\": %llu, \"misses\": %llu, "
+                  "\"writebacks\": %llu}",
+            stats->victimEntries, (unsigned long long)stats->victim.Hits,
+            (unsigned long long)stats->victim.Misses, (unsigned long long)stats->victim.Writebacks);
+  }
+
+  fprintf(file, ",\n  \"latency\": [");
+  int first = 1;
+
+  for (uint32_t i = 0; i <= stats->levels && i <= MAX_LEVELS; i++) {
+    for (int mode = 1; mode >= 0; mode--) {
+      const LatencyHistogram *histogram = &stats->latency[i][mode];
+
+      if (histogram->Count == 0)
+        continue;
+
+      fprintf(file, "%s\n    {\"served\": ", first ? "" : ",");
+      if (i < stats->levels)
+        fprintf(file, "\"l%u\"", i + 1);
+      else
+        fprintf(file, "\"dram\"");
+
+      fprintf(file, ", \"mode\": \"%s\", \"count\": %llu, \"mean\": %.2f, \"p50\": %llu, "
+                    "\"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu, \"buckets\": [",
+              mode == MODE_READ ? "read" : "write", (unsigned long long)histogram->Count,
+              (double)histogram->Sum / histogram->Count,
+              (unsigned long long)getLatencyPercentile(histogram, 0.5),
+              (unsigned long long)getLatencyPercentile(histogram, 0.9),
+              (unsigned long long)getLatencyPercentile(histogram, 0.99),
+              (unsigned long long)getLatencyPercentile(histogram, 0.999), (unsigned long long)histogram->Max);
+
+      /* [top latency of the bucket, count], empty buckets left out */
+      int firstBucket = 1;
+      for (uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        if (histogram->Buckets[bucket] == 0)
+          continue;
+
+        fprintf(file, "%s[%llu, %llu]", firstBucket ? "" : ", ", (unsigned long long)getBucketLatency(bucket),
+                (unsigned long long)histogram->Buckets[bucket]);
+        firstBucket = 0;
+      }
+
+      fprintf(file, "]}");
+      first = 0;
+    }
+  }
+
+  fprintf(file, "\n  ]\n}\n");
+}
+
+void writeStatsCSV(const Stats *stats, FILE *file) {
+  fprintf(file, "level,read_hits,read_misses,write_hits,write_misses,fills,evictions,writebacks,"
+                "forwards,buffer_stalls,prefetches,prefetch_useful,prefetch_late,prefetch_useless,"
+                "pollution,merged,mshr_stalls,back_invalidations,compulsory,capacity,conflict,reads,writes,bytes_read,bytes_written\n");
+
+  for (uint32_t i = 0; i < stats->levels; i++) {
+    const LevelStats *level = &stats->level[i];
+
+    fprintf(file, "l%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,,,,\n",
+            i + 1, (unsigned long long)level->Hits[MODE_READ],
+            (unsigned long long)level->Misses[MODE_READ],
+            (unsigned long long)level->Hits[MODE_WRITE],
+            (unsigned long long)level->Misses[MODE_WRITE], (unsigned long long)level->Fills,
+            (unsigned long long)level->Evictions, (unsigned long long)level->Writebacks,
+            (unsigned long long)level->Forwards, (unsigned long long)level->BufferStalls,
+            (unsigned long long)level->Prefetches, (unsigned long long)level->PrefetchUseful,
+            (unsigned long long)level->PrefetchLate, (unsigned long long)level->PrefetchUseless,
+            (unsigned long long)level->PrefetchPollution, (unsigned long long)level->Merged,
+            (unsigned long long)level->MshrStalls, (unsigned long long)level->BackInvalidations,
+            (unsigned long long)level->Compulsory, (unsigned long long)level->Capacity,
+            (unsigned long long)level->Conflict);
+  }
+
+  fprintf(file, "dram,,,,,,,,,,,,,,,,,,,,,%llu,%llu,%llu,%llu\n", (unsigned long long)stats->dram.Reads,
+          (unsigned long long)stats->dram.Writes, (unsigned long long)stats->dram.BytesRead,
+          (unsigned long long)stats->dram.BytesWritten);
+}
@@ -0,0 +1,164 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "Config.h"
+
+/*
+Per level and DRAM counters
+
+Every Simulator counts into its Stats as it goes, the counters are plain
+increments on paths the engine takes anyway so they are always on. Hits
+and misses are indexed by mode, Hits[MODE_READ] and Hits[MODE_WRITE].
+
+  fills       blocks brought in from the next level (every miss)
+  evictions   valid blocks replaced to make room
+  writebacks  dirty blocks written to the next level
+  forwards    writes passed on to the next level, write through and
+              write misses without allocation
+  stalls      cycles spent waiting for a full write buffer
+  prefetches  blocks filled by the prefetcher (see Prefetch.h), not fills
+  useful      prefetched blocks hit by a demand access, late when still in
+              flight, useless when evicted first
+  pollution   demand misses on blocks evicted by a prefetch
+  merged      accesses to a block whose miss is still in flight, served
+              by its MSHR (non-blocking levels only)
+  mshr stalls cycles an access waited for a free MSHR
+  back invalidations  copies invalidated in the levels above by evictions
+              of an inclusive level
+  compulsory, capacity, conflict  the misses split by cause (3C), only
+              counted with classify = 1, see Shadow.h
+
+accuracy = useful / prefetches, coverage = useful / (useful + misses) and
+timeliness = 1 - late / useful.
+
+With cores > 1 the private L1s of every core count into the l1 counters
+and the coherence protocol (see Coherence.h) counts into CoherenceStats:
+
+  invalidations   copies invalidated in other L1s by a write
+  upgrades        writes hitting a shared line
+  interventions   snoops that found a modified copy and wrote it back
+  coherence       misses on lines lost to an invalidation
+  false sharing   those of them on another word than the invalidating write
+
+With a victim cache (see Victim.h) VictimStats counts the L1 misses it
+caught (hits), the ones it did not (misses) and its dirty blocks written
+back to the next level, in the json output only.
+
+Every read() and write() also goes into a latency histogram, one per
+class: the level that served it (l1 .. l<levels>, DRAM as level levels)
+and its mode. The latency is the time the access moved the clock, on a
+non-blocking level only what it stalled (see Hierarchy.h). An access hit
+by the victim cache is served by l1.
+
+Histograms are log-linear like HdrHistogram: latencies below
+2^(LATENCY_SUB_BITS + 1) get a bucket each, above that every power of two
+is split into 2^LATENCY_SUB_BITS buckets, so a bucket is within 1/16 of its
+values. Recording is a count leading zeros and an increment, and
+percentiles are the top of the bucket they fall in. They are in the json
+output only, with the non-empty buckets.
+
+Counters keep going across initCache(), resetStats() clears them.
+*/
+
+#define LATENCY_SUB_BITS 4
+#define LATENCY_BUCKETS ((65 - LATENCY_SUB_BITS) << LATENCY_SUB_BITS) /* 64 bit latencies */
+
+typedef struct LevelStats {
+  uint64_t Hits[2];
+  uint64_t Misses[2];
+  uint64_t Fills;
+  uint64_t Evictions;
+  uint64_t Writebacks;
+  uint64_t Forwards;
+  uint64_t BufferStalls;
+  uint64_t Prefetches;
+  uint64_t PrefetchUseful;
+  uint64_t PrefetchLate;
+  uint64_t PrefetchUseless;
+  uint64_t PrefetchPollution;
+  uint64_t Merged;
+  uint64_t MshrStalls;
+  uint64_t BackInvalidations;
+  uint64_t Compulsory;
+  uint64_t Capacity;
+  uint64_t Conflict;
+} LevelStats;
+
+typedef struct DramStats {
+  uint64_t Reads;       /* in blocks */
+  uint64_t Writes;
+  uint64_t BytesRead;
+  uint64_t BytesWritten;
+} DramStats;
+
+typedef struct CoherenceStats {
+  uint64_t Invalidations;
+  uint64_t Upgrades;
+  uint64_t Interventions;
+  uint64_t CoherenceMisses;
+  uint64_t FalseSharing;
+} CoherenceStats;
+
+typedef struct VictimStats {
+  uint64_t Hits;
+  uint64_t Misses;
+  uint64_t Writebacks;
+} VictimStats;
+
+typedef struct LatencyHistogram {
+  uint64_t Count;
+  uint64_t Sum;
+  uint64_t Max;
+  uint64_t Buckets[LATENCY_BUCKETS];
+} LatencyHistogram;
+
+typedef struct Stats {
+  uint32_t levels;
+  uint32_t cores;
+  uint32_t victimEntries;
+  LevelStats level[MAX_LEVELS];
+  DramStats dram;
+  CoherenceStats coherence;
+  VictimStats victim;
+  LatencyHistogram latency[MAX_LEVELS + 1][2]; /* by level served and mode */
+} Stats;
+
+static inline uint32_t getLatencyBucket(uint64_t latency) {
+  if (latency < 2u << LATENCY_SUB_BITS)
+    return (uint32_t)latency;
+
+  uint32_t shift = 63 - __builtin_clzll(latency) - LATENCY_SUB_BITS;
+
+  return (shift << LATENCY_SUB_BITS) + (uint32_t)(latency >> shift);
+}
+
+static inline void recordLatency(LatencyHistogram *histogram, uint64_t latency) {
+  histogram->Count++;
+  histogram->Sum += latency;
+  if (latency > histogram->Max)
+    histogram->Max = latency;
+  histogram->Buckets[getLatencyBucket(latency)]++;
+}
+
+/* largest latency of a bucket */
+uint64_t getBucketLatency(uint32_t);
+
+/* latency at or below which a fraction of the accesses fall, 0 for none */
+uint64_t getLatencyPercentile(const LatencyHistogram *, double);
+
+void resetStats(Stats *);
+
+/* adds the counters of one run to another, e.g. to merge shards */
+void addStats(Stats *, const Stats *);
+
+void writeStatsJSON(const Stats *, FILE *);
+
+/*
+one row per level and one for dram, the level counters are empty for dram.
+The coherence counters are only in the json output, when cores > 1
+*/
+void writeStatsCSV(const Stats *, FILE *);
+
+#endif
@@ -0,0 +1,143 @@
+#include "Trace.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*********************** Reader *************************/
+
+/*
+maps the whole trace file read-only, the records are then accessed in place
+so replaying a trace never copies or decodes it
+*/
+int openTrace(Trace *trace, const char *path) {
+  memset(trace, 0, sizeof(Trace));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "trace: cannot open %s\n", path);
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(TraceHeader)) {
+    fprintf(stderr, "trace: %s is not a trace\n", path);
+    close(fd);
+    return -1;
+  }
+
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "trace: cannot map %s\n", path);
+    return -1;
+  }
+
+  const TraceHeader *header = (const TraceHeader *)map;
+  if (memcmp(header->Magic, TRACE_MAGIC, 4) != 0 ||
+      header->Version != TRACE_VERSION ||
+      header->RecordSize < sizeof(TraceRecord) ||
+      header->Count > (st.st_size - sizeof(TraceHeader)) / header->RecordSize) {
+    fprintf(stderr, "trace: %s has a bad header\n", path);
+    munmap(map, st.st_size);
+    return -1;
+  }
+
+  /* records are only ever walked front to back */
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  trace->map = map;
+  trace->mapSize = st.st_size;
+  trace->records = (const uint8_t *)map + sizeof(TraceHeader);
+  trace->recordSize = header->RecordSize;
+  trace->count = header->Count;
+
+  return 0;
+}
+
+void releaseTrace(const Trace *trace, uint64_t begin, uint64_t end) {
+  uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+  uintptr_t from = (uintptr_t)traceRecord(trace, begin) & ~(page - 1);
+  uintptr_t to = (uintptr_t)traceRecord(trace, end < trace->count ? end : trace->count) & ~(page - 1);
+
+  /* the page of record end is still needed, the page of begin is not */
+  if (to > from)
+    madvise((void *)from, to - from, MADV_DONTNEED);
+}
+
+void closeTrace(Trace *trace) {
+  if (trace->map != NULL)
+    munmap(trace->map, trace->mapSize);
+
+  memset(trace, 0, sizeof(Trace));
+}
+
+/*********************** Writer *************************/
+
+int openTraceWriter(TraceWriter *writer, const char *path) {
+  writer->count = 0;
+  writer->recordSize = sizeof(TraceRecord);
+  writer->file = fopen(path, "wb");
+  if (writer->file == NULL) {
+    fprintf(stderr, "trace: cannot create %s\n", path);
+    return -1;
+  }
+
+  /* large buffer, records are tiny */
+  setvbuf(writer->file, NULL, _IOFBF, 1 << 20);
+
+  /* header is rewritten with the final count on close */
+  TraceHeader header = {0};
+  fwrite(&header, sizeof(TraceHeader), 1, writer->file);
+
+  return 0;
+}
+
+void writeTracePcs(TraceWriter *writer) {
+  writer->recordSize = TRACE_PC_RECORD_SIZE;
+}
+
+void writeTraceRecord(TraceWriter *writer, uint8_t op, uint8_t size,
+                      uint16_t flags, uint64_t address, uint32_t value) {
+  writeTracePcRecord(writer, op, size, flags, address, value, 0);
+}
+
+/* the pc is dropped unless writeTracePcs() was called */
+void writeTracePcRecord(TraceWriter *writer, uint8_t op, uint8_t size,
+                        uint16_t flags, uint64_t address, uint32_t value, uint64_t pc) {
+  TracePcRecord record;
+
+  record.Record.Op = op;
+  record.Record.Size = size;
+  record.Record.Flags = flags;
+  record.Record.Value = value;
+  record.Record.Address = address;
+  record.Pc = pc;
+
+  fwrite(&record, writer->recordSize, 1, writer->file);
+  writer->count++;
+}
+
+int closeTraceWriter(TraceWriter *writer) {
+  TraceHeader header;
+
+  memcpy(header.Magic, TRACE_MAGIC, 4);
+  header.Version = TRACE_VERSION;
+  header.RecordSize = writer->recordSize;
+  header.Count = writer->count;
+
+  int failed = fseek(writer->file, 0, SEEK_SET) != 0 ||
+               fwrite(&header, sizeof(TraceHeader), 1, writer->file) != 1;
+
+  failed |= fclose(writer->file) != 0;
+  writer->file = NULL;
+
+  if (failed) {
+    fprintf(stderr, "trace: write failed\n");
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,126 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/*
+Binary trace format
+
+A trace is a fixed header followed by fixed-size records, all little endian.
+Records are laid out so that the mapped file can be walked as an array of
+TraceRecord without decoding anything.
+
+  offset 0   TraceHeader (16 bytes)
+  offset 16  TraceRecord[Count] (RecordSize bytes each)
+
+Readers step by RecordSize, so records may carry more than a TraceRecord.
+With RecordSize >= TRACE_PC_RECORD_SIZE each one is followed by the 64 bit
+program counter of the access (TracePcRecord), see tracePc().
+*/
+
+#define TRACE_MAGIC "CTRC"
+#define TRACE_VERSION 1
+
+/* Record operations */
+#define TRACE_READ 0
+#define TRACE_WRITE 1
+#define TRACE_RESET 2 /* resetTime() + initCache() */
+
+/* Record flags */
+#define TRACE_HAS_VALUE 0x1 /* Value holds the written / expected read value */
+
+typedef struct TraceHeader {
+  char Magic[4];
+  uint16_t Version;
+  uint16_t RecordSize;
+  uint64_t Count;
+} TraceHeader;
+
+typedef struct TraceRecord {
+  uint8_t Op;
+  uint8_t Size;   /* in bytes */
+  uint16_t Flags;
+  uint32_t Value;
+  uint64_t Address;
+} TraceRecord;
+
+typedef struct TracePcRecord {
+  TraceRecord Record;
+  uint64_t Pc;
+} TracePcRecord;
+
+#define TRACE_PC_RECORD_SIZE sizeof(TracePcRecord)
+
+/*********************** Reader *************************/
+
+typedef struct Trace {
+  void *map;
+  size_t mapSize;
+  const uint8_t *records;
+  uint32_t recordSize;
+  uint64_t count;
+} Trace;
+
+int openTrace(Trace *, const char *);
+void closeTrace(Trace *);
+
+/*
+drops the mapped pages holding only records in [begin, end) or the header,
+a reader done with them calls it so the resident part of a replayed trace
+stays a window instead of the whole file. The pages come back from the page
+cache if they are read again, so sharing a mapping is safe
+*/
+void releaseTrace(const Trace *, uint64_t begin, uint64_t end);
+
+static inline const TraceRecord *traceRecord(const Trace *trace, uint64_t i) {
+  return (const TraceRecord *)(trace->records + i * trace->recordSize);
+}
+
+/*
+bytes an access record covers, at least one. Its data is Value zero extended
+to that many bytes, little endian, so a record of up to 4 bytes holds any
+data and a wider one the low 4 bytes of it
+*/
+static inline uint32_t traceSize(const TraceRecord *record) { return record->Size > 0 ? record->Size : 1; }
+
+/*
+returns the number of blocks of 2^offsetBits bytes an access record covers
+and the address of the first one in *first. A record is accessed one block
+at a time, each access only the bytes of the record in that block, so an
+unaligned record never touches bytes it does not cover
+*/
+static inline uint32_t traceBlocks(const TraceRecord *record, uint32_t offsetBits, uint64_t *first) {
+  uint64_t last = (record->Address + traceSize(record) - 1) >> offsetBits;
+
+  *first = record->Address >> offsetBits << offsetBits;
+
+  return (uint32_t)(last - (record->Address >> offsetBits) + 1);
+}
+
+/* program counter of a record, 0 when the trace has none */
+static inline uint64_t tracePc(const Trace *trace, const TraceRecord *record) {
+  if (trace->recordSize < TRACE_PC_RECORD_SIZE)
+    return 0;
+
+  return ((const TracePcRecord *)record)->Pc;
+}
+
+/*********************** Writer *************************/
+
+typedef struct TraceWriter {
+  FILE *file;
+  uint64_t count;
+  uint32_t recordSize;
+} TraceWriter;
+
+int openTraceWriter(TraceWriter *, const char *);
+
+/* switches to TracePcRecords, before the first record is written */
+void writeTracePcs(TraceWriter *);
+
+void writeTraceRecord(TraceWriter *, uint8_t, uint8_t, uint16_t, uint64_t, uint32_t);
+void writeTracePcRecord(TraceWriter *, uint8_t, uint8_t, uint16_t, uint64_t, uint32_t, uint64_t);
+int closeTraceWriter(TraceWriter *);
+
+#endif
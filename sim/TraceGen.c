@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Cache.h"
+#include "Trace.h"
+
+/*
+Trace generator
+
+  TraceGen simple <out>         access pattern of SimpleProgram.c
+  TraceGen text <in> <out>      converts a text trace, one access per line:
+                                  R <address> [expected value]
+                                  W <address> <value>
+                                  X                (reset)
+                                an access may end in @<pc>, the program
+                                counter is then kept for every record
+                                (see Trace.h)
+  TraceGen <workload> <out> [accesses] [footprint]
+                                synthetic workloads for make bench, 4M word
+                                accesses over 1 MiB by default, one in four
+                                a write:
+                                  seq     word after word
+                                  stride  every 4 KiB + 1 block
+                                  random  uniformly random words
+                                  chase   pointer chase, one word per block
+                                          in a random cyclic order
+*/
+
+#define WORKLOAD_ACCESSES (4 << 20)
+#define WORKLOAD_FOOTPRINT (1 << 20)
+#define WORKLOAD_STRIDE (4096 + BLOCK_SIZE)
+
+#define WORKLOAD_SEQ 0
+#define WORKLOAD_STRIDED 1
+#define WORKLOAD_RANDOM 2
+#define WORKLOAD_CHASE 3
+#define WORKLOADS 4
+
+static const char *workloads[WORKLOADS] = {"seq", "stride", "random", "chase"};
+
+static void usage() {
+  fprintf(stderr, "usage: TraceGen simple <out>\n"
+                  "       TraceGen text <in> <out>\n"
+                  "       TraceGen seq|stride|random|chase <out> [accesses] [footprint]\n");
+  exit(-1);
+}
+
+/* xorshift64, fixed seed so workloads are the same on every run */
+static uint64_t nextRandom(uint64_t *state) {
+  uint64_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+
+  return *state = x;
+}
+
+/* same accesses, in the same order, as tests/SimpleProgram.c */
+static void generateSimple(TraceWriter *writer) {
+  srand(0);
+
+  for (int n = 1; n <= DRAM_SIZE / 4; n *= WORD_SIZE) {
+    writeTraceRecord(writer, TRACE_RESET, 0, 0, 0, 0);
+
+    for (int i = 0; i < n; i += WORD_SIZE)
+      writeTraceRecord(writer, TRACE_WRITE, WORD_SIZE, TRACE_HAS_VALUE, i, i);
+
+    for (int i = 0; i < n; i += WORD_SIZE)
+      writeTraceRecord(writer, TRACE_READ, WORD_SIZE, TRACE_HAS_VALUE, i, i);
+  }
+
+  for (int i = 0; i < 100; i++) {
+    int address = rand() % (DRAM_SIZE / 4);
+    address = address - address % WORD_SIZE;
+    int mode = rand() % 2;
+    if (mode == MODE_READ)
+      writeTraceRecord(writer, TRACE_READ, WORD_SIZE, 0, address, 0);
+    else
+      writeTraceRecord(writer, TRACE_WRITE, WORD_SIZE, TRACE_HAS_VALUE, address, address);
+  }
+}
+
+static int findWorkload(const char *name) {
+  for (int i = 0; i < WORKLOADS; i++) {
+    if (strcmp(workloads[i], name) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
+static int generateWorkload(TraceWriter *writer, int workload, uint64_t accesses, uint64_t footprint) {
+  uint64_t words = footprint / WORD_SIZE, blocks = footprint / BLOCK_SIZE;
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint32_t *next = NULL;
+  uint64_t block = 0;
+
+  if (blocks == 0) {
+    fprintf(stderr, "TraceGen: footprint must hold at least one block\n");
+    return -1;
+  }
+
+  if (workload == WORKLOAD_CHASE) {
+    /* Sattolo's shuffle, a single cycle through every block */
+    next = malloc(blocks * sizeof(uint32_t));
+    if (next == NULL)
+      return -1;
+
+    for (uint64_t i = 0; i < blocks; i++)
+      next[i] = i;
+
+    for (uint64_t i = blocks - 1; i > 0; i--) {
+      uint64_t j = nextRandom(&state) % i;
+      uint32_t swap = next[i];
+
+      next[i] = next[j];
+      next[j] = swap;
+    }
+  }
+
+  for (uint64_t i = 0; i < accesses; i++) {
+    uint64_t address;
+
+    if (workload == WORKLOAD_SEQ)
+      address = i % words * WORD_SIZE;
+    else if (workload == WORKLOAD_STRIDED)
+      address = i * WORKLOAD_STRIDE % (words * WORD_SIZE);
+    else if (workload == WORKLOAD_RANDOM)
+      address = nextRandom(&state) % words * WORD_SIZE;
+    else
+      address = (block = next[block]) * BLOCK_SIZE;
+
+    if (i % 4 == 3)
+      writeTraceRecord(writer, TRACE_WRITE, WORD_SIZE, TRACE_HAS_VALUE, address, (uint32_t)address);
+    else
+      writeTraceRecord(writer, TRACE_READ, WORD_SIZE, 0, address, 0);
+  }
+
+  free(next);
+  return 0;
+}
+
+static int convertText(TraceWriter *writer, const char *path) {
+  FILE *in = fopen(path, "r");
+  if (in == NULL) {
+    fprintf(stderr, "TraceGen: cannot open %s\n", path);
+    return -1;
+  }
+
+  char line[256];
+  int lineNumber = 0;
+
+  /* every record has the same size, so one pc anywhere means pcs throughout */
+  while (fgets(line, sizeof(line), in) != NULL) {
+    if (strchr(line, '@') != NULL) {
+      writeTracePcs(writer);
+      break;
+    }
+  }
+  rewind(in);
+
+  while (fgets(line, sizeof(line), in) != NULL) {
+    char op;
+    unsigned long long address;
+    unsigned long value;
+    char *at = strchr(line, '@');
+    uint64_t pc = at != NULL ? strtoull(at + 1, NULL, 0) : 0;
+
+    lineNumber++;
+
+    int fields = sscanf(line, " %c %lli %li", &op, &address, &value);
+    if (fields <= 0 || op == '#')
+      continue;
+
+    if (op == 'X')
+      writeTraceRecord(writer, TRACE_RESET, 0, 0, 0, 0);
+    else if (op == 'R' && fields >= 2)
+      writeTracePcRecord(writer, TRACE_READ, WORD_SIZE,
+                         fields == 3 ? TRACE_HAS_VALUE : 0, address,
+                         fields == 3 ? value : 0, pc);
+    else if (op == 'W' && fields == 3)
+      writeTracePcRecord(writer, TRACE_WRITE, WORD_SIZE, TRACE_HAS_VALUE, address, value, pc);
+    else {
+      fprintf(stderr, "TraceGen: %s:%d: bad record\n", path, lineNumber);
+      fclose(in);
+      return -1;
+    }
+  }
+
+  fclose(in);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  TraceWriter writer;
+  int failed;
+
+  if (argc == 3 && strcmp(argv[1], "simple") == 0) {
+    if (openTraceWriter(&writer, argv[2]) < 0)
+      return -1;
+    generateSimple(&writer);
+    failed = 0;
+  } else if (argc == 4 && strcmp(argv[1], "text") == 0) {
+    if (openTraceWriter(&writer, argv[3]) < 0)
+      return -1;
+    failed = convertText(&writer, argv[2]);
+  } else if (argc >= 3 && argc <= 5 && findWorkload(argv[1]) >= 0) {
+    uint64_t accesses = argc > 3 ? strtoull(argv[3], NULL, 0) : WORKLOAD_ACCESSES;
+    uint64_t footprint = argc > 4 ? strtoull(argv[4], NULL, 0) : WORKLOAD_FOOTPRINT;
+
+    if (openTraceWriter(&writer, argv[2]) < 0)
+      return -1;
+    failed = generateWorkload(&writer, findWorkload(argv[1]), accesses, footprint);
+  } else {
+    usage();
+    return -1;
+  }
+
+  if (closeTraceWriter(&writer) < 0 || failed)
+    return -1;
+
+  return 0;
+}
@@ -0,0 +1,487 @@
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "Hierarchy.h"
+#include "Trace.h"
+#include "Output.h"
+#include "Profile.h"
+
+/*
+Trace runner, replays a binary trace (see Trace.h) through read()/write()
+
+  TraceProgram [-p] [-o <log>] [-v] [-b] [-j <threads>] [-S <stats>]
+               [-a <report> [-r <regions>]] [-c <config>] [-s <key>=<value>]... <trace>...
+
+  -p  print every access like SimpleProgram.c does, same as -o -
+  -o  log every access to this file, text, gzip'ed text when it ends in .gz
+      or binary when it ends in .bin (see Output.h)
+  -v  check read values against the values recorded in the trace
+  -b  time the replay and print one benchmark line to stdout, simulated
+      accesses per second, ns per access and peak RSS (see make bench), the
+      trace is released behind the replay so it does not count
+  -j  simulate on this many threads, a power of two, see below
+  -S  write the per level counters (see Stats.h) to this file at exit, csv
+      when it ends in .csv and json otherwise, - for stdout
+  -a  write the misses and added time of every pc and region to this file,
+      - for stdout (see Profile.h)
+  -r  load the named address regions for -a from this file
+  -c  load cache geometry from a config file (see Config.h)
+  -s  override a single config option, applied after -c
+
+DRAM is unbounded (dram.size = 0) unless -c or -s set a size.
+
+Cores
+
+With cores = n (see Config.h) n traces are given, trace i is replayed by
+core i through its private L1. The traces are interleaved one record at a
+time, a core drops out when its trace ends, and a reset in any of them
+resets the whole simulator. Coherence only involves copies of one block so
+sharding still holds.
+
+Sharding (-j)
+
+Blocks are split into shards by the low bits of their block address. When
+the shard count divides the set count of every level, a set of any level
+only ever holds blocks of one shard and write backs stay in their shard, so
+each thread replays the whole trace through its own Simulator but only
+performs the accesses of its shard. Latencies add up, so the summed
+accesses, time and mismatches are those of a serial run, and so are the
+summed Stats. State shared across sets would diverge and is refused:
+random and brrip policies, write buffers, prefetchers, MSHRs and the
+victim cache. So are -p
+and -o since the order of accesses is lost.
+*/
+
+/* records replayed between two releaseTrace() calls */
+#define RELEASE_RECORDS (1 << 16)
+
+typedef struct Shard {
+  const Trace *traces;  /* one per core */
+  const Config *config;
+  uint32_t shard;
+  uint32_t shards;
+  Output *output;
+  int verify;
+  int failed;
+  Profile *profile;     /* -a, NULL when not attributing */
+
+  /* results */
+  uint64_t accesses;
+  uint64_t mismatches;
+  uint64_t time;        /* since the last reset */
+  Stats stats;
+} Shard;
+
+static void usage() {
+  fprintf(stderr, "usage: TraceProgram [-p] [-o <log>] [-v] [-b] [-j <threads>] [-S <stats>] "
+                  "[-a <report> [-r <regions>]] [-c <config>] [-s <key>=<value>]... <trace>...\n");
+  exit(-1);
+}
+
+static int writeStats(const Stats *stats, const char *path) {
+  size_t length = strlen(path);
+  FILE *file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+
+  if (file == NULL) {
+    fprintf(stderr, "TraceProgram: cannot open %s\n", path);
+    return -1;
+  }
+
+  if (length > 4 && strcmp(path + length - 4, ".csv") == 0)
+    writeStatsCSV(stats, file);
+  else
+    writeStatsJSON(stats, file);
+
+  if (file != stdout)
+    fclose(file);
+
+  return 0;
+}
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* one line per run so make bench output can be sorted and diffed */
+static void printBench(const char *program, const char *path, uint64_t accesses, double seconds) {
+  const char *engine = strrchr(program, '/');
+  const char *trace = strrchr(path, '/');
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("%-10s %-22s %12llu accesses %10.2f Macc/s %8.2f ns/access %8ld KiB peak rss\n",
+         engine ? engine + 1 : program, trace ? trace + 1 : path,
+         (unsigned long long)accesses, accesses / seconds * 1e-6,
+         accesses ? seconds * 1e9 / accesses : 0.0, usage.ru_maxrss);
+}
+
+static int writeReport(const Profile *profile, const char *path) {
+  FILE *file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+
+  if (file == NULL) {
+    fprintf(stderr, "TraceProgram: cannot open %s\n", path);
+    return -1;
+  }
+
+  writeProfile(profile, file);
+
+  if (file != stdout)
+    fclose(file);
+
+  return 0;
+}
+
+/* the counters an access is charged with, before and after it */
+static void takeCounters(const Simulator *sim, ProfileCounters *counters) {
+  const LevelStats *l1 = &sim->stats.level[0];
+
+  counters->Accesses = 0;
+  counters->Misses = l1->Misses[MODE_READ] + l1->Misses[MODE_WRITE];
+  counters->Dram = sim->stats.dram.Reads;
+  counters->Time = sim->time;
+}
+
+/* charges an access with what it cost beyond an L1 hit */
+static void attribute(Shard *shard, const Simulator *sim, const ProfileCounters *before,
+                      uint64_t pc, uint64_t address, uint32_t mode) {
+  const LevelConfig *l1 = &sim->config.level[0];
+  uint32_t hitTime = mode == MODE_WRITE ? l1->WriteTime : l1->ReadTime;
+  ProfileCounters access;
+
+  takeCounters(sim, &access);
+  access.Accesses = 1;
+  access.Misses -= before->Misses;
+  access.Dram -= before->Dram;
+  access.Time = access.Time - before->Time > hitTime ? access.Time - before->Time - hitTime : 0;
+
+  profileAccess(shard->profile, pc, address, &access);
+}
+
+/* the first (up to) 4 bytes of an access, as output */
+static uint32_t outputValue(const uint8_t *data, uint32_t size) {
+  uint32_t value = 0;
+
+  memcpy(&value, data, size < sizeof(value) ? size : sizeof(value));
+  return value;
+}
+
+/* replays one record of core, accesses of other shards are skipped */
+static void replayRecord(Shard *shard, Simulator *sim, uint32_t core, const TraceRecord *record,
+                         uint64_t pc) {
+  uint32_t offsetBits = shard->config->OffsetBits;
+  uint32_t blockSize = shard->config->BlockSize;
+  uint32_t shardMask = shard->shards - 1;
+  ProfileCounters before = {0};
+
+  if (record->Op == TRACE_RESET) {
+    resetTime(sim);
+    initCache(sim);
+    return;
+  }
+
+  /* the record's bytes, Value zero extended (see Trace.h) */
+  uint8_t expected[256] = {0}, data[256];
+  memcpy(expected, &record->Value, sizeof(record->Value));
+
+  /* accesses are split at block boundaries, each only touches the bytes of the record */
+  uint64_t block, start = record->Address, end = start + traceSize(record);
+  uint32_t blocks = traceBlocks(record, offsetBits, &block);
+
+  for (uint32_t b = 0; b < blocks; b++, block += blockSize) {
+    uint64_t address = start > block ? start : block;
+    uint32_t size = (uint32_t)((end < block + blockSize ? end : block + blockSize) - address);
+    uint8_t *bytes = expected + (address - start);
+
+    if (((address >> offsetBits) & shardMask) != shard->shard)
+      continue;
+
+    if (shard->profile != NULL)
+      takeCounters(sim, &before);
+
+    if (record->Op == TRACE_WRITE) {
+      writeBytes(sim, core, address, bytes, size);
+
+      writeOutput(shard->output, TRACE_WRITE, address, outputValue(bytes, size), getTime(sim));
+    } else {
+      memset(data, 0, size); /* left as is in tag only mode */
+      readBytes(sim, core, address, data, size);
+
+      if (shard->verify && (record->Flags & TRACE_HAS_VALUE) && memcmp(data, bytes, size) != 0)
+        shard->mismatches++;
+
+      writeOutput(shard->output, TRACE_READ, address, outputValue(data, size), getTime(sim));
+    }
+
+    if (shard->profile != NULL)
+      attribute(shard, sim, &before, pc, address, record->Op == TRACE_WRITE ? MODE_WRITE : MODE_READ);
+
+    shard->accesses++;
+  }
+}
+
+/*
+replays the accesses of one shard, a single shard covers every access. With
+several cores their traces are interleaved one record at a time
+*/
+static void *replay(void *arg) {
+  Shard *shard = arg;
+  uint32_t cores = shard->config->Cores;
+  uint64_t count = 0;
+  Simulator sim;
+
+  if (initSimulator(&sim, shard->config) < 0) {
+    shard->failed = 1;
+    return NULL;
+  }
+
+  resetTime(&sim);
+
+  for (uint32_t core = 0; core < cores; core++) {
+    if (shard->traces[core].count > count)
+      count = shard->traces[core].count;
+  }
+
+  for (uint64_t n = 0; n < count; n++) {
+    /* the replayed records are not read again, so the peak RSS of -b is the simulator's */
+    if (n > 0 && n % RELEASE_RECORDS == 0) {
+      for (uint32_t core = 0; core < cores; core++)
+        releaseTrace(&shard->traces[core], n - RELEASE_RECORDS, n);
+    }
+
+    for (uint32_t core = 0; core < cores; core++) {
+      if (n < shard->traces[core].count) {
+        const TraceRecord *record = traceRecord(&shard->traces[core], n);
+
+        replayRecord(shard, &sim, core, record, tracePc(&shard->traces[core], record));
+      }
+    }
+  }
+
+  shard->time = getTime(&sim);
+  shard->stats = sim.stats;
+  freeSimulator(&sim);
+
+  return NULL;
+}
+
+/* checks that no set of any level is shared between shards */
+static int checkShards(const Config *config, uint32_t shards) {
+  if (shards == 0 || (shards & (shards - 1)) != 0) {
+    fprintf(stderr, "TraceProgram: -j %u is not a power of two\n", shards);
+    return -1;
+  }
+
+  if (shards > 1 && config->VictimEntries > 0) {
+    fprintf(stderr, "TraceProgram: the victim cache is shared by all sets, it cannot be sharded\n");
+    return -1;
+  }
+
+  if (shards > 1 && config->Classify) {
+    fprintf(stderr, "TraceProgram: the 3C shadow caches are fully associative, they cannot be sharded\n");
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < config->Levels && shards > 1; i++) {
+    const LevelConfig *level = &config->level[i];
+
+    if (level->Sets % shards != 0) {
+      fprintf(stderr, "TraceProgram: -j %u is more than the %u sets of l%u\n",
+              shards, level->Sets, i + 1);
+      return -1;
+    }
+
+    if (level->Policy == POLICY_RANDOM || level->Policy == POLICY_BRRIP) {
+      fprintf(stderr, "TraceProgram: the l%u policy is shared by all sets, "
+                      "it cannot be sharded\n", i + 1);
+      return -1;
+    }
+
+    if (level->WriteBuffer > 0 || level->Prefetch != PREFETCH_NONE || level->Mshrs > 0) {
+      fprintf(stderr, "TraceProgram: the l%u write buffer, prefetcher or mshrs are shared by all sets, "
+                      "it cannot be sharded\n", i + 1);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const char *paths[MAX_CORES];
+  uint32_t traceCount = 0;
+  const char *outputPath = NULL;
+  int verify = 0;
+  int bench = 0;
+  uint32_t threads = 1;
+  const char *statsPath = NULL;
+  const char *reportPath = NULL;
+  const char *regionsPath = NULL;
+  Config config;
+
+  defaultConfig(&config);
+
+  /* traces can use any address, DRAM is sparse so only its pages cost */
+  config.DramSize = 0;
+
+  /* -c is applied first so -s always wins */
+  for (int i = 1; i < argc - 1; i++) {
+    if (strcmp(argv[i], "-c") == 0 && loadConfig(&config, argv[i + 1]) < 0)
+      return -1;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-p") == 0)
+      outputPath = "-";
+    else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      outputPath = argv[++i];
+    else if (strcmp(argv[i], "-v") == 0)
+      verify = 1;
+    else if (strcmp(argv[i], "-b") == 0)
+      bench = 1;
+    else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+      threads = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+      statsPath = argv[++i];
+    else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+      reportPath = argv[++i];
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      regionsPath = argv[++i];
+    else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+      i++;
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      if (parseConfigOption(&config, argv[++i]) < 0)
+        return -1;
+    }
+    else if (argv[i][0] != '-' && traceCount < MAX_CORES)
+      paths[traceCount++] = argv[i];
+    else
+      usage();
+  }
+
+  if (traceCount == 0 || (outputPath != NULL && threads > 1) || (regionsPath != NULL && reportPath == NULL))
+    usage();
+
+  if (finalizeConfig(&config) < 0 || checkShards(&config, threads) < 0)
+    return -1;
+
+  if (verify && config.TagOnly) {
+    fprintf(stderr, "TraceProgram: -v needs data, it cannot be used with tag_only\n");
+    return -1;
+  }
+
+  if (traceCount != config.Cores) {
+    fprintf(stderr, "TraceProgram: %u traces given for %u cores, one per core\n",
+            traceCount, config.Cores);
+    return -1;
+  }
+
+  Trace traces[MAX_CORES];
+  for (uint32_t i = 0; i < traceCount; i++) {
+    if (openTrace(&traces[i], paths[i]) < 0)
+      return -1;
+  }
+
+  /* only ever written by shard 0, there is a single shard when logging */
+  Output output;
+  if (openOutput(&output, outputPath) < 0)
+    return -1;
+
+  Region *regions = NULL;
+  uint32_t regionCount = 0;
+  if (regionsPath != NULL && loadRegions(&regions, &regionCount, regionsPath) < 0)
+    return -1;
+
+  Shard *shards = calloc(threads, sizeof(Shard));
+  pthread_t *workers = calloc(threads, sizeof(pthread_t));
+  Profile *profiles = calloc(threads, sizeof(Profile));
+  if (shards == NULL || workers == NULL || profiles == NULL)
+    exit(-1);
+
+  for (uint32_t i = 0; i < threads; i++) {
+    shards[i].traces = traces;
+    shards[i].config = &config;
+    shards[i].shard = i;
+    shards[i].shards = threads;
+    shards[i].verify = verify;
+    shards[i].output = &output;
+
+    /* one profile per shard, merged into the first one */
+    if (reportPath != NULL) {
+      initProfile(&profiles[i], regions, regionCount);
+      shards[i].profile = &profiles[i];
+    }
+  }
+
+  /* the trace is already mapped, only the replay is timed */
+  double start = now();
+
+  /* the main thread simulates shard 0 itself */
+  for (uint32_t i = 1; i < threads; i++) {
+    if (pthread_create(&workers[i], NULL, replay, &shards[i]) != 0)
+      exit(-1);
+  }
+
+  replay(&shards[0]);
+
+  uint64_t accesses = 0, mismatches = 0;
+  uint64_t time = 0;
+  int failed = 0;
+  Stats stats = {0};
+
+  for (uint32_t i = 0; i < threads; i++) {
+    if (i > 0)
+      pthread_join(workers[i], NULL);
+
+    accesses += shards[i].accesses;
+    mismatches += shards[i].mismatches;
+    time += shards[i].time;
+    failed |= shards[i].failed;
+    addStats(&stats, &shards[i].stats);
+
+    if (i > 0 && reportPath != NULL)
+      addProfile(&profiles[0], &profiles[i]);
+  }
+
+  double seconds = now() - start;
+
+  free(shards);
+  free(workers);
+  for (uint32_t i = 0; i < traceCount; i++)
+    closeTrace(&traces[i]);
+
+  if (closeOutput(&output) < 0 || failed)
+    return -1;
+
+  fprintf(stderr, "accesses %llu; time %llu", (unsigned long long)accesses, (unsigned long long)time);
+  if (config.Cores > 1)
+    fprintf(stderr, "; invalidations %llu; false sharing %llu",
+            (unsigned long long)stats.coherence.Invalidations,
+            (unsigned long long)stats.coherence.FalseSharing);
+  if (verify)
+    fprintf(stderr, "; mismatches %llu", (unsigned long long)mismatches);
+  fprintf(stderr, "\n");
+
+  if (bench)
+    printBench(argv[0], paths[0], accesses, seconds);
+
+  if (statsPath != NULL && writeStats(&stats, statsPath) < 0)
+    return -1;
+
+  if (reportPath != NULL) {
+    failed = writeReport(&profiles[0], reportPath) < 0;
+
+    for (uint32_t i = 0; i < threads; i++)
+      freeProfile(&profiles[i]);
+    if (failed)
+      return -1;
+  }
+
+  free(profiles);
+  free(regions);
+
+  return verify && mismatches ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+#include "Victim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void initVictimCache(VictimCache *victim, uint32_t entries, uint32_t blockSize, uint32_t tagOnly) {
+  if (victim->blocks == NULL || victim->entries != entries || victim->blockSize != blockSize ||
+      (victim->data == NULL) != (tagOnly != 0)) {
+    freeVictimCache(victim);
+
+    victim->blocks = malloc((entries + 1) * sizeof(uint64_t));
+    victim->used = malloc((entries + 1) * sizeof(uint64_t));
+    victim->dirty = malloc(entries + 1);
+    victim->data = tagOnly ? NULL : malloc((size_t)entries * blockSize);
+    victim->scratch = malloc(blockSize);
+    if (victim->blocks == NULL || victim->used == NULL || victim->dirty == NULL ||
+        (victim->data == NULL && !tagOnly) || victim->scratch == NULL)
+      exit(-1);
+
+    victim->entries = entries;
+    victim->blockSize = blockSize;
+  }
+
+  /* a handful of entries, emptied outright */
+  memset(victim->blocks, 0, entries * sizeof(uint64_t));
+  memset(victim->used, 0, entries * sizeof(uint64_t));
+  memset(victim->dirty, 0, entries);
+  victim->clock = 0;
+}
+
+void freeVictimCache(VictimCache *victim) {
+  free(victim->blocks);
+  free(victim->used);
+  free(victim->dirty);
+  free(victim->data);
+  free(victim->scratch);
+
+  memset(victim, 0, sizeof(VictimCache));
+}
+
+int findVictim(const VictimCache *victim, uint64_t block) {
+  for (uint32_t i = 0; i < victim->entries; i++) {
+    if (victim->blocks[i] == block + 1)
+      return i;
+  }
+
+  return -1;
+}
+
+uint32_t getVictimEntry(const VictimCache *victim) {
+  uint32_t oldest = 0;
+
+  for (uint32_t i = 0; i < victim->entries; i++) {
+    if (victim->blocks[i] == 0)
+      return i;
+
+    if (victim->used[i] < victim->used[oldest])
+      oldest = i;
+  }
+
+  return oldest;
+}
+
+void touchVictim(VictimCache *victim, uint32_t entry) {
+  victim->used[entry] = ++victim->clock;
+}
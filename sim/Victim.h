@@ -0,0 +1,50 @@
+#ifndef VICTIM_H
+#define VICTIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Victim cache between L1 and L2
+
+A small fully associative buffer of blocks (victim.entries, see Config.h)
+that catches the blocks L1 evicts. An L1 miss looks in it before going to
+L2: on a hit the block and the L1 victim swap places, costing victim.time
+instead of a trip to L2. Otherwise L1 fills from L2 as usual and its victim
+goes to the victim cache, whose least recently used entry is written back
+to L2 when dirty. Blocks keep their dirty bit through the swaps.
+
+The victim cache sits outside the coherence protocol, so it needs cores = 1.
+*/
+
+#define MAX_VICTIM_ENTRIES 64
+
+typedef struct VictimCache {
+  uint32_t entries;
+  uint32_t blockSize;
+  uint64_t *blocks;     /* block address + 1, 0 when free */
+  uint64_t *used;       /* last use, for LRU */
+  uint8_t *dirty;
+  uint8_t *data;        /* entries * blockSize bytes, NULL in tag only mode */
+  uint8_t *scratch;     /* one block, for swaps */
+  uint64_t clock;
+} VictimCache;
+
+/* allocates the entries when their number or size changed and empties them */
+void initVictimCache(VictimCache *, uint32_t, uint32_t, uint32_t);
+void freeVictimCache(VictimCache *);
+
+/* returns the entry holding a block address, -1 if there is none */
+int findVictim(const VictimCache *, uint64_t);
+
+/* returns a free entry, or the least recently used one when all are taken */
+uint32_t getVictimEntry(const VictimCache *);
+
+/* marks an entry as just used */
+void touchVictim(VictimCache *, uint32_t);
+
+static inline uint8_t *getVictimData(const VictimCache *victim, uint32_t entry) {
+  return victim->data == NULL ? NULL : victim->data + (size_t)entry * victim->blockSize;
+}
+
+#endif